@@ -0,0 +1,87 @@
+// Async throughput with unpinned flushers versus pinned ones
+// (to given CPUs and to NUMA nodes of producers)
+//
+// affinity_bench [records per producer] [producers] [flushers]
+
+#include <logger/ll.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void run(const std::string& name, const ll::logger::async_options& options, size_t records, size_t producers)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::atomic<uint64_t> handled(0);
+    auto& log = ll::logger::instance();
+    log.add_destination([&handled](const ll::logger::log_message&, int) {
+        handled.fetch_add(1, std::memory_order_relaxed);
+    });
+    log.unlock();
+    log.set_level(ll::logger::level_trace).init_async_log(options);
+
+    const auto start = clock::now();
+    std::vector<std::thread> threads;
+    for (size_t ci = 0; ci < producers; ++ci)
+    {
+        threads.emplace_back([records, ci]() {
+            for (size_t cj = 0; cj < records; ++cj)
+            {
+                LOG_DEBUG("producer " << ci << " request " << cj << " handled, status=ok");
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    const auto produced = clock::now();
+    log.flush();
+    const auto written = clock::now();
+
+    ll::logger::destroy();
+
+    const double total = static_cast<double>(records * producers);
+    const double produce_s = std::chrono::duration<double>(produced - start).count();
+    const double total_s = std::chrono::duration<double>(written - start).count();
+
+    std::cout << name
+              << ": producers " << static_cast<uint64_t>(total / produce_s) << " rec/s"
+              << ", total " << static_cast<uint64_t>(total / total_s) << " rec/s"
+              << ", handled " << handled.load()
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const size_t records = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const size_t producers = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 4;
+    const size_t flushers = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 2;
+
+    ll::logger::async_options options;
+    options.flushers = flushers;
+
+    run("unpinned", options, records, producers);
+
+    // The last CPUs
+    const int cpus = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (size_t ci = 0; ci < flushers; ++ci)
+    {
+        options.cpu_affinity.push_back(std::max(0, cpus - 1 - static_cast<int>(ci)));
+    }
+    run("pinned to CPUs", options, records, producers);
+
+    options.cpu_affinity.clear();
+    options.numa_affinity = true;
+    run("pinned to NUMA nodes", options, records, producers);
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+// Escaping throughput of scalar, SSE2 and AVX2 scans
+// for clean text and for text with rare special bytes
+//
+// escape_bench [megabytes]
+
+#include "json_writer.h"
+#include "text_escape.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+
+using server_lib::escape_isa;
+
+const char* isa_name(escape_isa isa)
+{
+    switch (isa)
+    {
+    case escape_isa::scalar:
+        return "scalar";
+    case escape_isa::sse2:
+        return "sse2";
+    case escape_isa::avx2:
+        return "avx2";
+    default:;
+    }
+    return "";
+}
+
+// Messages of typical size with special byte every 'period' bytes (never if zero)
+std::string make_text(size_t size, size_t period)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::string text(size, ' ');
+    for (size_t ci = 0; ci < size; ++ci)
+    {
+        if (period && ci % period == period - 1)
+            text[ci] = (ci % 2) ? '\n' : '"';
+        else if (ci % 7)
+            text[ci] = static_cast<char>(letter(rng));
+    }
+    return text;
+}
+
+template <typename Escape>
+void measure(const std::string& name, const std::string& text, size_t total_bytes, Escape&& escape)
+{
+    using clock = std::chrono::steady_clock;
+
+    // Message sized pieces like destinations escape
+    static const size_t message_size = 200;
+    const size_t rounds = std::max<size_t>(1, total_bytes / text.size());
+
+    std::string out;
+    size_t check = 0;
+    const auto start = clock::now();
+    for (size_t ci = 0; ci < rounds; ++ci)
+    {
+        for (size_t offset = 0; offset < text.size(); offset += message_size)
+        {
+            out.clear();
+            escape(out, text.data() + offset, std::min(message_size, text.size() - offset));
+            check += out.size();
+        }
+    }
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::cout << name << ": " << static_cast<uint64_t>(static_cast<double>(rounds * text.size()) / seconds / (1 << 20)) << " MB/s"
+              << " (" << check % 10 << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const size_t megabytes = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 256;
+    const size_t total_bytes = megabytes << 20;
+
+    const std::string clean = make_text(1 << 20, 0);
+    const std::string sparse = make_text(1 << 20, 100);
+
+    for (auto isa : { escape_isa::scalar, escape_isa::sse2, escape_isa::avx2 })
+    {
+        if (!server_lib::set_escape_isa(isa))
+        {
+            std::cout << isa_name(isa) << ": unsupported" << std::endl;
+            continue;
+        }
+
+        const std::string prefix = isa_name(isa);
+        measure(prefix + " json clean", clean, total_bytes, server_lib::append_json_escaped);
+        measure(prefix + " json 1% special", sparse, total_bytes, server_lib::append_json_escaped);
+        measure(prefix + " sanitize clean", clean, total_bytes, server_lib::append_sanitized);
+        measure(prefix + " sanitize 1% special", sparse, total_bytes, server_lib::append_sanitized);
+    }
+    return 0;
+}
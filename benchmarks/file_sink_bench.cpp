@@ -0,0 +1,102 @@
+// Throughput of file destination: raw blocks versus LZ compressed ones,
+// writev versus io_uring. CPU time (all threads) is reported per MB
+//
+// file_sink_bench [records] [directory]
+
+#include <logger/ll.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <ctime>
+#include <string>
+#include <sys/stat.h>
+
+namespace {
+
+size_t file_size(const std::string& path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return 0;
+    return static_cast<size_t>(st.st_size);
+}
+
+double process_cpu_seconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+void run(const std::string& name, const std::string& path, size_t records, const ll::logger::file_options& options, bool async)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::remove(path.c_str());
+
+    auto& log = ll::logger::instance();
+    log.init_file_log(path, options).set_level(ll::logger::level_trace);
+    if (async)
+        log.init_async_log();
+
+    const auto start = clock::now();
+    const auto start_cpu = process_cpu_seconds();
+    for (size_t ci = 0; ci < records; ++ci)
+    {
+        LOG_DEBUG("request " << ci << " handled, user=" << (ci % 1000) << " status=ok");
+    }
+    const auto produced = clock::now();
+    log.flush();
+    const auto written = clock::now();
+    const auto cpu_s = process_cpu_seconds() - start_cpu;
+
+    const auto bytes = log.stats().destinations.at(0).bytes;
+    ll::logger::destroy();
+
+    const auto size = file_size(path);
+    std::remove(path.c_str());
+
+    const double produce_s = std::chrono::duration<double>(produced - start).count();
+    const double total_s = std::chrono::duration<double>(written - start).count();
+    const double mb = static_cast<double>(bytes) / (1 << 20);
+
+    std::cout << name
+              << ": producer " << static_cast<uint64_t>(records / produce_s) << " rec/s"
+              << ", total " << static_cast<uint64_t>(records / total_s) << " rec/s"
+              << ", " << static_cast<uint64_t>(mb / total_s) << " MB/s"
+              << ", CPU " << (mb > 0 ? cpu_s * 1000 / mb : 0) << " ms/MB"
+              << ", file " << size << " bytes (ratio " << (size ? static_cast<double>(bytes) / size : 0) << ")"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const size_t records = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const std::string directory = (argc > 2) ? argv[2] : "/tmp";
+    const std::string path = directory + "/file_sink_bench.log";
+
+    ll::logger::file_options raw;
+    ll::logger::file_options compressed;
+    compressed.compress = true;
+    ll::logger::file_options raw_uring;
+    raw_uring.use_io_uring = true;
+    ll::logger::file_options compressed_uring = compressed;
+    compressed_uring.use_io_uring = true;
+    ll::logger::file_options raw_sqpoll = raw_uring;
+    raw_sqpoll.sqpoll = true;
+
+    run("raw", path, records, raw, false);
+    run("compressed", path, records, compressed, false);
+    run("raw async", path, records, raw, true);
+    run("compressed async", path, records, compressed, true);
+    run("raw io_uring", path, records, raw_uring, false);
+    run("compressed io_uring", path, records, compressed_uring, false);
+    run("raw io_uring async", path, records, raw_uring, true);
+    run("raw io_uring sqpoll", path, records, raw_sqpoll, false);
+
+    return 0;
+}
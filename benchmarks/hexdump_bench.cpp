@@ -0,0 +1,80 @@
+// Hex dump formatting throughput of ll::hexdump against
+// hand-written std::stringstream loop
+//
+// hexdump_bench [megabytes]
+
+#include <logger/ll.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Typical hex loop of packet traces
+void stringstream_dump(std::ostream& out, const unsigned char* data, size_t size)
+{
+    std::stringstream ss;
+    for (size_t ci = 0; ci < size; ++ci)
+    {
+        if (ci % 16 == 0)
+            ss << '\n'
+               << std::hex << std::setw(8) << std::setfill('0') << ci << "  ";
+        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(data[ci]) << ' ';
+    }
+    out << ss.str();
+}
+
+template <typename Dump>
+void measure(const std::string& name, const std::vector<unsigned char>& packet, size_t total_bytes, Dump&& dump)
+{
+    using clock = std::chrono::steady_clock;
+
+    const size_t rounds = std::max<size_t>(1, total_bytes / packet.size());
+
+    // Reused as message stream is
+    std::ostringstream out;
+    size_t check = 0;
+    const auto start = clock::now();
+    for (size_t ci = 0; ci < rounds; ++ci)
+    {
+        out.str(std::string());
+        dump(out, packet.data(), packet.size());
+        check += static_cast<size_t>(out.tellp());
+    }
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::cout << name << ": " << static_cast<uint64_t>(static_cast<double>(rounds * packet.size()) / seconds / (1 << 20)) << " MB/s"
+              << " (" << check % 10 << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const size_t megabytes = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 64;
+    const size_t total_bytes = megabytes << 20;
+
+    for (size_t size : { 64, 1500 })
+    {
+        std::vector<unsigned char> packet(size);
+        for (size_t ci = 0; ci < size; ++ci)
+            packet[ci] = static_cast<unsigned char>(ci * 7);
+
+        const std::string suffix = " " + std::to_string(size) + " bytes";
+        measure("stringstream" + suffix, packet, total_bytes, stringstream_dump);
+        measure("hexdump" + suffix, packet, total_bytes, [](std::ostream& out, const unsigned char* data, size_t size) {
+            out << ll::hexdump(data, size);
+        });
+        measure("hexdump compact" + suffix, packet, total_bytes, [](std::ostream& out, const unsigned char* data, size_t size) {
+            ll::hexdump_options options;
+            options.compact = true;
+            out << ll::hexdump(data, size, options);
+        });
+    }
+    return 0;
+}
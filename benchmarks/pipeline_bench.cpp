@@ -0,0 +1,94 @@
+// Dispatch of several sinks as std::function destinations versus
+// single static pipeline (records are written synchronously)
+//
+// pipeline_bench [records] [sinks: 1..4]
+
+#include <logger/ll.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// Cheap sink to make dispatch dominate
+struct counting_sink
+{
+    explicit counting_sink(uint64_t& counter)
+        : _counter(&counter)
+    {
+    }
+
+    bool operator()(ll::pipeline_record& record)
+    {
+        *_counter += static_cast<uint64_t>(record.msg.context.line);
+        return true;
+    }
+
+private:
+    uint64_t* _counter;
+};
+
+template <typename AddSinks>
+void run(const std::string& name, size_t records, AddSinks&& add_sinks)
+{
+    using clock = std::chrono::steady_clock;
+
+    uint64_t counter = 0;
+    auto& log = ll::logger::instance();
+    add_sinks(log, counter);
+    log.unlock();
+    log.set_level(ll::logger::level_trace);
+
+    const auto start = clock::now();
+    for (size_t ci = 0; ci < records; ++ci)
+    {
+        LOG_DEBUG("request " << ci);
+    }
+    const auto finished = clock::now();
+
+    ll::logger::destroy();
+
+    const double total_ns = std::chrono::duration<double, std::nano>(finished - start).count();
+    std::cout << name
+              << ": " << static_cast<uint64_t>(total_ns / static_cast<double>(records)) << " ns/record"
+              << ", checksum " << counter
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const size_t records = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const size_t sinks = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 4;
+
+    run("std::function", records, [sinks](ll::logger& log, uint64_t& counter) {
+        for (size_t ci = 0; ci < sinks; ++ci)
+        {
+            log.add_destination([&counter](const ll::logger::log_message& msg, int) {
+                counter += static_cast<uint64_t>(msg.context.line);
+            });
+        }
+    });
+
+    run("pipeline", records, [sinks](ll::logger& log, uint64_t& counter) {
+        switch (sinks)
+        {
+        case 1:
+            log.add_destination(ll::make_pipeline(counting_sink(counter)));
+            break;
+        case 2:
+            log.add_destination(ll::make_pipeline(counting_sink(counter), counting_sink(counter)));
+            break;
+        case 3:
+            log.add_destination(ll::make_pipeline(counting_sink(counter), counting_sink(counter), counting_sink(counter)));
+            break;
+        default:
+            log.add_destination(ll::make_pipeline(counting_sink(counter), counting_sink(counter), counting_sink(counter), counting_sink(counter)));
+        }
+    });
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+// Fixed format time functions versus generic (libc) path
+//
+// time_format_bench [iterations]
+
+#include <logger/logger.h>
+#include <logger/time_helper.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+namespace {
+
+template <typename Function>
+void measure(const std::string& name, size_t iterations, Function&& function)
+{
+    using clock = std::chrono::steady_clock;
+
+    size_t check = 0;
+    const auto start = clock::now();
+    for (size_t ci = 0; ci < iterations; ++ci)
+        check += function(ci);
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::cout << name << ": " << static_cast<uint64_t>(seconds * 1e9 / iterations) << " ns/call"
+              << " (" << check % 10 << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const size_t iterations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const char* format = server_lib::logger::default_time_format;
+    const time_t base = std::time(nullptr);
+
+    measure("format_iso_time", iterations, [&](size_t ci) {
+        char buff[64];
+        size_t size = 0;
+        server_lib::format_iso_time(base + static_cast<time_t>(ci), format, buff, sizeof(buff), size, false);
+        return size;
+    });
+    measure("strftime", iterations, [&](size_t ci) {
+        char buff[64];
+        time_t t = base + static_cast<time_t>(ci);
+        std::tm tp {};
+        localtime_r(&t, &tp);
+        return std::strftime(buff, sizeof(buff), format, &tp);
+    });
+
+    const std::string text = server_lib::to_iso_string(base, format, false);
+    measure("parse_iso_time", iterations, [&](size_t) {
+        time_t result = 0;
+        server_lib::parse_iso_time(text.data(), text.size(), format, result, false);
+        return static_cast<size_t>(result);
+    });
+    // Formats out of fast path go to std::get_time
+    measure("parse_iso_time (generic)", iterations / 10, [&](size_t) {
+        time_t result = 0;
+        server_lib::parse_iso_time(text.data(), text.size(), "%Y-%m-%dT%H:%M:%S%n", result, false);
+        return static_cast<size_t>(result);
+    });
+
+    return 0;
+}
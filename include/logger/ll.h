@@ -3,7 +3,26 @@
 // Light Logger
 
 #include <logger/logging_helper.h>
+#include <logger/log_pipeline.h>
+#include <logger/log_hexdump.h>
 
 namespace ll {
 using logger = server_lib::logger;
+using server_lib::buffered_scope;
+using server_lib::context_guard;
+using server_lib::file_sink;
+using server_lib::hexdump;
+using server_lib::hexdump_options;
+using server_lib::kv;
+using server_lib::lazy;
+using server_lib::lazy_copy;
+using server_lib::level_filter;
+using server_lib::log_site;
+using server_lib::make_pipeline;
+using server_lib::pipeline;
+using server_lib::pipeline_record;
+using server_lib::render_json;
+using server_lib::render_text;
+using server_lib::site_mode;
+using server_lib::stream_sink;
 }
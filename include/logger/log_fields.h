@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace server_lib {
+
+/**
+ * \brief Typed key-value field of structured record
+ *
+ * Value is stored unformatted and rendered by destination.
+ * Key is not copied so it should be string literal (static storage).
+ */
+struct log_field
+{
+    enum class type
+    {
+        integer,
+        unsigned_integer,
+        floating,
+        boolean,
+        string,
+    };
+
+    const char* key = nullptr;
+    type kind = type::integer;
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        double d;
+        bool b;
+    } value;
+    std::string text;
+};
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, log_field>::type
+kv(const char* key, T value)
+{
+    log_field field;
+    field.key = key;
+    field.kind = log_field::type::integer;
+    field.value.i = static_cast<int64_t>(value);
+    return field;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value, log_field>::type
+kv(const char* key, T value)
+{
+    log_field field;
+    field.key = key;
+    field.kind = log_field::type::unsigned_integer;
+    field.value.u = static_cast<uint64_t>(value);
+    return field;
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, log_field>::type
+kv(const char* key, T value)
+{
+    log_field field;
+    field.key = key;
+    field.kind = log_field::type::floating;
+    field.value.d = static_cast<double>(value);
+    return field;
+}
+
+inline log_field kv(const char* key, bool value)
+{
+    log_field field;
+    field.key = key;
+    field.kind = log_field::type::boolean;
+    field.value.b = value;
+    return field;
+}
+
+inline log_field kv(const char* key, std::string value)
+{
+    log_field field;
+    field.key = key;
+    field.kind = log_field::type::string;
+    field.value.u = 0;
+    field.text = std::move(value);
+    return field;
+}
+
+inline log_field kv(const char* key, const char* value)
+{
+    return kv(key, std::string { value ? value : "" });
+}
+
+} // namespace server_lib
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+namespace server_lib {
+
+struct hexdump_options
+{
+    // Bytes per row (1..64)
+    size_t width = 16;
+    // Bytes dumped at most, the rest are only counted. All if zero
+    size_t max_bytes = 4096;
+    // Offset column of classic layout
+    bool offsets = true;
+    // ASCII column of classic layout
+    bool ascii = true;
+    // Single line of hex digits instead of rows
+    bool compact = false;
+};
+
+/**
+ * \brief Binary payload for message (see hexdump)
+ *
+ * Data is formatted when part is streamed, so it must be alive
+ * until then only.
+ */
+struct hexdump_part
+{
+    const void* data;
+    size_t size;
+    hexdump_options options;
+};
+
+// Classic layout (every row starts new line):
+//
+//   LOG_TRACE("packet " << ll::hexdump(buff, size));
+//
+//   packet
+//   00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 21 0a 00 ff  |Hello, world!...|
+//   00000010  01 02                                             |..|
+//
+// Bytes beyond max_bytes are replaced by "... N more bytes"
+inline hexdump_part hexdump(const void* data, size_t size, const hexdump_options& options = hexdump_options())
+{
+    return { data, size, options };
+}
+
+// Rows are encoded by table into stack buffer and written
+// to stream buffer without intermediate strings
+std::ostream& operator<<(std::ostream& out, const hexdump_part& part);
+
+} // namespace server_lib
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+namespace server_lib {
+
+/**
+ * \brief Part of record message rendered by writing thread
+ *
+ * It is rendered only if record passed filters, in async mode
+ * it is rendered by flusher instead of producer thread.
+ * Callable (or value) is kept by value so it must not refer
+ * to objects of the call site by reference.
+ */
+struct log_deferred
+{
+    virtual ~log_deferred() = default;
+    virtual void render(std::ostream& out) const = 0;
+};
+
+template <typename Render>
+struct log_deferred_impl : public log_deferred
+{
+    explicit log_deferred_impl(Render&& r)
+        : render_(std::move(r))
+    {
+    }
+
+    void render(std::ostream& out) const override
+    {
+        render_(out);
+    }
+
+    Render render_;
+};
+
+template <typename Render>
+struct lazy_part
+{
+    Render render;
+};
+
+template <typename Render>
+std::ostream& operator<<(std::ostream& out, const lazy_part<Render>& part)
+{
+    // Out of record it is rendered at once
+    part.render(out);
+    return out;
+}
+
+template <typename Function>
+struct lazy_call
+{
+    Function function;
+
+    void operator()(std::ostream& out) const
+    {
+        out << function();
+    }
+};
+
+template <typename T>
+struct lazy_copy_value
+{
+    T value;
+
+    void operator()(std::ostream& out) const
+    {
+        out << value;
+    }
+};
+
+// LOG_DEBUG("request " << ll::lazy([request]() { return request.dump(); }))
+template <typename Function>
+lazy_part<lazy_call<typename std::decay<Function>::type>> lazy(Function&& function)
+{
+    return { { std::forward<Function>(function) } };
+}
+
+// LOG_DEBUG("request " << ll::lazy_copy(request)). Value is copied or moved
+template <typename T>
+lazy_part<lazy_copy_value<typename std::decay<T>::type>> lazy_copy(T&& value)
+{
+    return { { std::forward<T>(value) } };
+}
+
+} // namespace server_lib
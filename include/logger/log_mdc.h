@@ -0,0 +1,146 @@
+#pragma once
+
+#include "log_fields.h"
+
+#include <atomic>
+#include <string>
+#include <utility>
+
+namespace server_lib {
+
+class log_context_frame;
+
+/**
+ * \brief Shared reference to frame of thread context stack
+ *
+ * Counter is intrusive, so reference could be passed through
+ * raw async records (release/adopt).
+ */
+class log_context_ref
+{
+public:
+    log_context_ref() = default;
+    log_context_ref(const log_context_ref& other);
+    log_context_ref(log_context_ref&& other) noexcept
+        : _frame(other._frame)
+    {
+        other._frame = nullptr;
+    }
+    ~log_context_ref();
+
+    log_context_ref& operator=(log_context_ref other) noexcept
+    {
+        std::swap(_frame, other._frame);
+        return *this;
+    }
+
+    // Takes reference counted by release
+    static log_context_ref adopt(const log_context_frame* frame)
+    {
+        log_context_ref ref;
+        ref._frame = frame;
+        return ref;
+    }
+
+    const log_context_frame* release()
+    {
+        auto frame = _frame;
+        _frame = nullptr;
+        return frame;
+    }
+
+    const log_context_frame* get() const
+    {
+        return _frame;
+    }
+
+    explicit operator bool() const
+    {
+        return _frame != nullptr;
+    }
+
+    const log_context_frame* operator->() const
+    {
+        return _frame;
+    }
+
+private:
+    const log_context_frame* _frame = nullptr;
+};
+
+/**
+ * \brief Immutable frame of thread context stack (MDC)
+ *
+ * Fields of the whole stack are rendered once when frame
+ * is pushed, records made under frame refer to it.
+ */
+class log_context_frame
+{
+public:
+    log_context_frame(log_context_ref parent, log_field&& field);
+
+    log_context_frame(const log_context_frame&) = delete;
+    log_context_frame& operator=(const log_context_frame&) = delete;
+
+    const log_context_ref& parent() const
+    {
+        return _parent;
+    }
+
+    const log_field& field() const
+    {
+        return _field;
+    }
+
+    // Text prefix of message: "[req=42 user=bob] "
+    const std::string& text() const
+    {
+        return _text;
+    }
+
+    // JSON members: ,"req":42,"user":"bob"
+    const std::string& json() const
+    {
+        return _json;
+    }
+
+private:
+    friend class log_context_ref;
+
+    const log_context_ref _parent;
+    const log_field _field;
+    std::string _text;
+    std::string _json;
+    mutable std::atomic<size_t> _refs { 1 };
+};
+
+/**
+ * \brief Pushes field to context stack of the calling thread
+ * while guard is alive. Records of the thread refer to stack top
+ *
+ *   ll::context_guard guard("req", request_id);
+ *   LOG_INFO("started");   // "[req=42] started"
+ */
+class context_guard
+{
+public:
+    template <typename T>
+    context_guard(const char* key, T&& value)
+        : context_guard(kv(key, std::forward<T>(value)))
+    {
+    }
+
+    explicit context_guard(log_field&& field);
+    ~context_guard();
+
+    context_guard(const context_guard&) = delete;
+    context_guard& operator=(const context_guard&) = delete;
+
+private:
+    log_context_ref _previous;
+};
+
+// Top of context stack of the calling thread
+const log_context_ref& this_thread_context();
+
+} // namespace server_lib
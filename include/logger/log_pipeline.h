@@ -0,0 +1,198 @@
+#pragma once
+
+#include "logger.h"
+
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace server_lib {
+
+class file_writer;
+
+// Record passed through stages of pipeline
+struct pipeline_record
+{
+    const logger::log_message& msg;
+    int details_filter;
+    // Rendered by render stage for the next sinks
+    std::string& text;
+};
+
+/**
+ * \brief Destination composed of stages at compile time
+ *
+ * Every stage is called as bool(pipeline_record&) in order, false
+ * stops the record (filter). Calls of stages are inlined into single
+ * function that logger calls through plain pointer (std::function
+ * destinations are called the same way). Text is rendered once into
+ * thread buffer for all sinks after render stage. Stage could have
+ * flush() that is called by logger::flush.
+ *
+ *   ll::logger::instance().add_destination(ll::make_pipeline(
+ *       ll::level_filter(ll::logger::level_info),
+ *       ll::render_text(),
+ *       ll::file_sink("app.log"),
+ *       ll::stream_sink(std::cerr)));
+ */
+template <typename... Stages>
+class pipeline
+{
+    static_assert(sizeof...(Stages) > 0, "Pipeline without stages");
+
+    template <size_t Index>
+    using index = std::integral_constant<size_t, Index>;
+    using end_index = index<sizeof...(Stages)>;
+
+public:
+    explicit pipeline(Stages... stages)
+        : _stages(std::move(stages)...)
+    {
+    }
+
+    void operator()(const logger::log_message& msg, int details_filter)
+    {
+        thread_local std::string text;
+        text.clear();
+
+        pipeline_record record { msg, details_filter, text };
+        run(record, index<0>());
+    }
+
+    void flush()
+    {
+        flush_stages(index<0>());
+    }
+
+private:
+    void run(pipeline_record&, end_index)
+    {
+    }
+
+    template <size_t Index>
+    void run(pipeline_record& record, index<Index>)
+    {
+        if (std::get<Index>(_stages)(record))
+            run(record, index<Index + 1>());
+    }
+
+    void flush_stages(end_index)
+    {
+    }
+
+    template <size_t Index>
+    void flush_stages(index<Index>)
+    {
+        flush_stage(std::get<Index>(_stages), 0);
+        flush_stages(index<Index + 1>());
+    }
+
+    template <typename Stage>
+    static auto flush_stage(Stage& stage, int) -> decltype(stage.flush(), void())
+    {
+        stage.flush();
+    }
+
+    template <typename Stage>
+    static void flush_stage(Stage&, long)
+    {
+    }
+
+private:
+    std::tuple<Stages...> _stages;
+};
+
+template <typename... Stages>
+pipeline<typename std::decay<Stages>::type...> make_pipeline(Stages&&... stages)
+{
+    return pipeline<typename std::decay<Stages>::type...>(std::forward<Stages>(stages)...);
+}
+
+// Passes records by level filter (as logger::set_level)
+class level_filter
+{
+public:
+    explicit level_filter(int filter)
+        : _filter(filter)
+    {
+    }
+
+    bool operator()(pipeline_record& record) const
+    {
+        const auto lv = static_cast<int>(record.msg.context.lv);
+        return !lv || !(_filter & lv);
+    }
+
+private:
+    int _filter;
+};
+
+// Row of CLI layout (as init_cli_log). Thread info is prefixed
+// by pid if required (for file_sink in shared mode). Control bytes
+// are escaped if sanitize (as logger::set_sanitize_text)
+class render_text
+{
+public:
+    explicit render_text(const char* time_format = logger::default_time_format, bool with_pid = false, bool sanitize = false);
+
+    bool operator()(pipeline_record& record) const;
+
+private:
+    std::string _time_format;
+    bool _with_pid;
+    bool _sanitize;
+};
+
+// JSON Lines (as init_json_log)
+class render_json
+{
+public:
+    bool operator()(pipeline_record& record) const;
+};
+
+// Writes rendered text to stream that isn't written by other destinations
+class stream_sink
+{
+public:
+    explicit stream_sink(std::ostream& stream)
+        : _stream(&stream)
+        , _mutex(new std::mutex)
+    {
+    }
+
+    bool operator()(pipeline_record& record)
+    {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _stream->write(record.text.data(), static_cast<std::streamsize>(record.text.size()));
+        return true;
+    }
+
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _stream->flush();
+    }
+
+private:
+    std::ostream* _stream;
+    std::unique_ptr<std::mutex> _mutex;
+};
+
+// Writes rendered text to file by own thread (as init_file_log)
+class file_sink
+{
+public:
+    explicit file_sink(const std::string& path, const logger::file_options& options = logger::file_options());
+
+    bool operator()(pipeline_record& record);
+    void flush();
+
+private:
+    std::shared_ptr<file_writer> _writer;
+};
+
+} // namespace server_lib
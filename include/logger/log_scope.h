@@ -0,0 +1,72 @@
+#pragma once
+
+#include "logger.h"
+
+#include <deque>
+
+namespace server_lib {
+
+/**
+ * \brief Keeps records of the calling thread that are less severe
+ * than threshold while scope is alive (e.g. debug lines of request)
+ *
+ * Records are kept without rendering (and regardless of level
+ * filter) in bounded buffer, the oldest ones are dropped if it is full.
+ * Buffer is discarded on scope exit. It is written in order if error
+ * or fatal record is logged inside scope (outer scopes are written
+ * before) or if scope is committed. Then the rest records of scope
+ * are written immediately. Scope destroyed out of order
+ * is unlinked from the chain of thread.
+ *
+ *   ll::buffered_scope scope;
+ *   LOG_DEBUG("parsed " << request);   // kept
+ *   LOG_ERROR("failed");               // writes "parsed ..." then "failed"
+ */
+class buffered_scope
+{
+public:
+    explicit buffered_scope(logger::level threshold = logger::level::info, size_t capacity = 256);
+    ~buffered_scope();
+
+    buffered_scope(const buffered_scope&) = delete;
+    buffered_scope& operator=(const buffered_scope&) = delete;
+
+    // Writes kept records, the next ones aren't kept
+    void commit();
+    // Drops kept records
+    void discard();
+
+    size_t size() const
+    {
+        return _records.size();
+    }
+
+    // Dropped by overflow
+    size_t dropped() const
+    {
+        return _dropped;
+    }
+
+    bool committed() const
+    {
+        return _committed;
+    }
+
+private:
+    friend class logger;
+
+    // Called by logger::write. True if record is taken by scope
+    static bool capture(logger::log_message& msg);
+
+    void write_records();
+
+private:
+    const int _threshold;
+    const size_t _capacity;
+    buffered_scope* _parent;
+    std::deque<logger::log_message> _records;
+    size_t _dropped = 0;
+    bool _committed = false;
+};
+
+} // namespace server_lib
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "logger.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace server_lib {
+
+enum class site_mode : uint8_t
+{
+    // Record passes level filter as usual
+    level = 1,
+    // Record is written regardless of level filter
+    on = 2,
+    // Record is skipped at call site
+    off = 3,
+};
+
+/**
+ * \brief Static descriptor of LOG_* call site (dynamic debug)
+ *
+ * Descriptor is constant initialized and is registered in global
+ * intrusive list at the first call of site. Registration takes
+ * the rules lock (once per site), so its mode is set by the last
+ * matching rule of logger::set_sites consistently with rules set
+ * concurrently. The list is walked without lock. Call site checks
+ * mode by single byte load:
+ *
+ *   ll::logger::instance().set_sites("file worker.cpp line 120", ll::site_mode::on);
+ *   ll::logger::instance().set_sites("func parse_*", ll::site_mode::off);
+ *
+ * Registered site has counters of hits (see logger::set_site_profiling)
+ * sharded by thread.
+ */
+class log_site
+{
+public:
+    constexpr log_site(logger::level lv, const char* file, int line, const char* function)
+        : _lv(lv)
+        , _file(file)
+        , _line(line)
+        , _function(function)
+        , _mode(0)
+        , _next(nullptr)
+        , _shards(nullptr)
+    {
+    }
+
+    log_site(const log_site&) = delete;
+    log_site& operator=(const log_site&) = delete;
+
+    bool switched_off() const
+    {
+        return _mode.load(std::memory_order_relaxed) == static_cast<uint8_t>(site_mode::off);
+    }
+
+    // Registers site at the first call
+    site_mode mode();
+
+    struct counters
+    {
+        uint64_t hits = 0;
+        // Hits filtered by level
+        uint64_t filtered = 0;
+        // Message bytes
+        uint64_t bytes = 0;
+        // Clock ticks from call site to written (or filtered) of sampled hits
+        uint64_t ticks = 0;
+        uint64_t samples = 0;
+    };
+
+    // For registered site only. Zero ticks if hit isn't sampled
+    void record_hit(bool filtered, uint64_t bytes, uint64_t ticks, bool sampled);
+    counters collect() const;
+
+    logger::level lv() const
+    {
+        return _lv;
+    }
+
+    const char* file() const
+    {
+        return _file;
+    }
+
+    int line() const
+    {
+        return _line;
+    }
+
+    const char* function() const
+    {
+        return _function;
+    }
+
+    // Applies rule to registered sites and keeps it for the next ones.
+    // Query is words "file <glob>", "func <glob>", "line <number>" in any
+    // combination ("*" and "?" in globs, file glob matches path or base name).
+    // Rule with the same query replaces previous one. Returns count of
+    // matched registered sites. Throws if query is invalid
+    static size_t set_mode(const std::string& query, site_mode mode);
+    // Drops rule of the query, registered sites get mode of remaining
+    // rules. False if there is no such rule
+    static bool clear_mode(const std::string& query);
+    // Drops rules, registered sites are switched to level mode
+    static void reset_modes();
+    // Zeroes counters of registered sites
+    static void reset_counters();
+
+    // Visits registered sites (without locks)
+    template <typename Visitor>
+    static void for_each(Visitor&& visitor)
+    {
+        for (auto site = s_head.load(std::memory_order_acquire); site; site = site->_next)
+        {
+            visitor(*site);
+        }
+    }
+
+private:
+    struct alignas(64) counters_shard
+    {
+        std::atomic<uint64_t> hits { 0 };
+        std::atomic<uint64_t> filtered { 0 };
+        std::atomic<uint64_t> bytes { 0 };
+        std::atomic<uint64_t> ticks { 0 };
+        std::atomic<uint64_t> samples { 0 };
+    };
+
+    static const size_t shards_count = 8;
+
+    site_mode register_site();
+
+private:
+    const logger::level _lv;
+    const char* const _file;
+    const int _line;
+    const char* const _function;
+    // Zero before registration
+    std::atomic<uint8_t> _mode;
+    log_site* _next;
+    // Allocated by registration (never freed as site is static)
+    counters_shard* _shards;
+
+    static std::atomic<log_site*> s_head;
+};
+
+} // namespace server_lib
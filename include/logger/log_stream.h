@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace server_lib {
+
+/**
+ * \brief String buffer of record message with text readable
+ * in place (str() copies it)
+ */
+class message_stringbuf : public std::stringbuf
+{
+public:
+    message_stringbuf() = default;
+    message_stringbuf(message_stringbuf&&) = default;
+    message_stringbuf& operator=(message_stringbuf&&) = default;
+
+    const char* text_data() const
+    {
+        return pbase();
+    }
+
+    // High mark of written text as str() takes it
+    size_t text_size() const
+    {
+        const char* begin = pbase();
+        const char* end = std::max<const char*>(pptr(), egptr());
+        return begin ? static_cast<size_t>(end - begin) : 0;
+    }
+};
+
+/**
+ * \brief std::stringstream of record message over message_stringbuf
+ */
+class message_stream : public std::iostream
+{
+public:
+    message_stream()
+        : std::iostream(nullptr)
+    {
+        init(&_buffer);
+    }
+
+    message_stream(message_stream&& other)
+        : std::iostream(std::move(other))
+        , _buffer(std::move(other._buffer))
+    {
+        set_rdbuf(&_buffer);
+    }
+
+    message_stream& operator=(message_stream&& other)
+    {
+        std::iostream::operator=(std::move(other));
+        _buffer = std::move(other._buffer);
+        return *this;
+    }
+
+    message_stringbuf* rdbuf() const
+    {
+        return const_cast<message_stringbuf*>(&_buffer);
+    }
+
+    std::string str() const
+    {
+        return _buffer.str();
+    }
+
+    void str(const std::string& text)
+    {
+        _buffer.str(text);
+    }
+
+    const char* text_data() const
+    {
+        return _buffer.text_data();
+    }
+
+    size_t text_size() const
+    {
+        return _buffer.text_size();
+    }
+
+private:
+    message_stringbuf _buffer;
+};
+
+} // namespace server_lib
@@ -9,11 +9,31 @@
 #include <utility>
 #include <mutex>
 #include <tuple>
+#include <memory>
+#include <chrono>
+#include <array>
+#include <limits>
+#include <csignal>
 
 #include "singleton.h"
+#include "log_fields.h"
+#include "log_lazy.h"
+#include "log_mdc.h"
+#include "log_stream.h"
 
 namespace server_lib {
 
+class async_writer;
+class file_writer;
+class logger_stats;
+class config_watcher;
+class buffered_scope;
+class log_site;
+enum class site_mode : uint8_t;
+
+template <typename... Stages>
+class pipeline;
+
 class logger : public singleton<logger>
 {
 public:
@@ -29,6 +49,28 @@ public:
         trace = 0x10,
     };
 
+    // Position in per level arrays: fatal, error, warning, info, debug, trace
+    static size_t level_index(level lv)
+    {
+        switch (lv)
+        {
+        case level::fatal:
+            return 0;
+        case level::error:
+            return 1;
+        case level::warning:
+            return 2;
+        case level::info:
+            return 3;
+        case level::debug:
+            return 4;
+        case level::trace:
+            return 5;
+        default:;
+        }
+        return 0;
+    }
+
     static const int level_trace; // 0
     static const int level_debug; // 16
     static const int level_info; // 24
@@ -52,9 +94,13 @@ public:
     static const int details_message_without_source_code; // 33
     static const int details_message_only; // 63
 
+    using clock_type = std::chrono::system_clock;
+
     struct log_context
     {
         unsigned long id;
+        // Raw clock reading captured at construction (at call site)
+        uint64_t timestamp;
         level lv;
         std::string file;
         int line;
@@ -62,9 +108,18 @@ public:
 
         using thread_info_type = std::tuple<uint64_t, std::string, bool>;
         thread_info_type thread_info;
+        // Process of record (cached, refreshed in forked child)
+        int pid;
+        // Thread context fields (see context_guard)
+        log_context_ref mdc;
+        // Call site descriptor of LOG_* macros (see log_site.h)
+        log_site* site;
 
         log_context();
 
+        // Wall-clock time of timestamp
+        clock_type::time_point time() const;
+
     private:
         static std::atomic_ulong s_id_counter;
     };
@@ -72,26 +127,195 @@ public:
     struct log_message
     {
         log_context context;
-        std::stringstream message;
+        message_stream message;
+        // Structured fields (see kv)
+        std::vector<log_field> fields;
+        // Lazy parts (see lazy) with their positions in message
+        std::vector<std::pair<size_t, std::unique_ptr<log_deferred>>> deferred;
+
+        template <typename T>
+        log_message& operator<<(T&& value)
+        {
+            message << std::forward<T>(value);
+            return *this;
+        }
+
+        log_message& operator<<(std::ostream& (*manipulator)(std::ostream&))
+        {
+            message << manipulator;
+            return *this;
+        }
+
+        log_message& operator<<(std::ios_base& (*manipulator)(std::ios_base&))
+        {
+            message << manipulator;
+            return *this;
+        }
+
+        template <typename Render>
+        log_message& operator<<(lazy_part<Render>&& part)
+        {
+            const auto position = static_cast<size_t>(message.tellp());
+            deferred.emplace_back(position, std::unique_ptr<log_deferred>(new log_deferred_impl<Render>(std::move(part.render))));
+            return *this;
+        }
+
+        // Renders lazy parts into message
+        void render_deferred();
+
+        template <typename... Fields>
+        void add_fields(Fields&&... items)
+        {
+            fields.reserve(fields.size() + sizeof...(items));
+            int expand[] = { 0, (fields.push_back(std::forward<Fields>(items)), 0)... };
+            (void)expand;
+        }
     };
 
     using log_handler_type = std::function<void(const log_message&, int details_filter)>;
 
+    struct async_options
+    {
+        async_options();
+
+        // Threads to write records for all destinations
+        size_t flushers;
+        // Records buffered per producer thread. Records are laid out
+        // in byte ring of queue_capacity * 256 bytes
+        size_t queue_capacity;
+        // CPU for every flusher (round robin). Not pinned if empty
+        std::vector<int> cpu_affinity;
+        // Pin flushers to NUMA nodes (round robin) and drain producer
+        // queue by flusher of the producer's node. Ignored with cpu_affinity
+        bool numa_affinity;
+        // Flushers are named "<prefix>-flusher-N", merger "<prefix>-merger".
+        // Not named if empty
+        std::string thread_name_prefix;
+        // If not zero the single flusher merges per-thread queues
+        // by time. Record waits up to this window for earlier ones
+        std::chrono::microseconds reorder_window;
+        // Drop (and count) record if queue is full instead of waiting
+        bool drop_on_overflow;
+        // No flusher threads (for single threaded event loop): records
+        // are written by drain() when drain_fd() is readable. Thread
+        // waiting for flush or for room in full queue writes records
+        // itself. Flushers, affinity and reorder window aren't used
+        bool external_drain;
+    };
+
+    struct file_options
+    {
+        file_options();
+
+        // Rotate file if it would exceed this size. Never if zero
+        size_t rotation_size;
+        // Rotated files path.1 ... path.N kept
+        size_t max_files;
+        // Write blocks in LZ frames (see lz_block.h)
+        bool compress;
+        // Uncompressed bytes buffered before writing
+        size_t block_size;
+        // Partial block is written after this period
+        std::chrono::milliseconds flush_period;
+        // Side index path.idx with time range of every block (for ll-query)
+        bool write_index;
+        // CPUs for writer thread ("ll-file"). Not pinned if empty
+        std::vector<int> cpu_affinity;
+        // Several processes append to the same file: every block of whole
+        // records is one write on O_APPEND descriptor, rows get pid and
+        // rotation is coordinated by flock on path.lock
+        bool shared;
+        // Submit writes through io_uring (registered buffers) instead of
+        // writev. Falls back to writev if io_uring is unavailable or shared
+        bool use_io_uring;
+        // Kernel thread polls io_uring submissions (IORING_SETUP_SQPOLL)
+        bool sqpoll;
+    };
+
+    struct stats_snapshot
+    {
+        static const size_t levels_count = 6;
+        static const size_t latency_buckets = 32;
+
+        struct destination_stats
+        {
+            uint64_t records = 0;
+            // Reported by built-in destinations only
+            uint64_t bytes = 0;
+            std::chrono::nanoseconds time { 0 };
+        };
+
+        // By level_index
+        std::array<uint64_t, levels_count> accepted;
+        std::array<uint64_t, levels_count> filtered;
+        // In order of adding
+        std::vector<destination_stats> destinations;
+        // Max records waiting in single async queue
+        uint64_t queue_high_water = 0;
+        // Failed by destination or by queue overflow
+        uint64_t drops = 0;
+        // Bucket N counts records written in [2^N, 2^(N+1)) ns after call site
+        std::array<uint64_t, latency_buckets> write_latency;
+    };
+
+    struct site_profile
+    {
+        struct site_stats
+        {
+            std::string file;
+            int line = 0;
+            std::string method;
+            level lv = level::fatal;
+            uint64_t hits = 0;
+            // Hits filtered by level (message was built anyway)
+            uint64_t filtered = 0;
+            uint64_t bytes = 0;
+            // From call site to written (or filtered), estimated by samples
+            std::chrono::nanoseconds time { 0 };
+        };
+
+        // The greatest first, sites without hits are skipped
+        std::vector<site_stats> by_hits;
+        std::vector<site_stats> by_bytes;
+        std::vector<site_stats> by_time;
+    };
+
 protected:
     logger();
+    ~logger();
 
     friend class singleton<logger>;
 
 public:
     logger& init_cli_log(const char* time_format = logger::default_time_format);
     logger& init_sys_log();
+    // JSON Lines to standard output
+    logger& init_json_log();
+    // Records to shared memory ring read by ll-collector process.
+    // Writer never blocks: records are dropped if ring is full
+    logger& init_shm_log(const std::string& name, size_t capacity = 4 << 20);
+    // Rows of CLI layout to file. Blocks are compressed and written
+    // by own thread of destination
+    logger& init_file_log(const std::string& path, const file_options& options = file_options());
+    // Records are written by flusher threads instead of producer one
+    logger& init_async_log(const async_options& options = async_options());
+
+    // Fatal records (and error ones if switched on) bypass async queues
+    // and buffers: they are written synchronously after pending records
+    // of the same thread with flush (and sync of file) of destinations
+    logger& set_sync_errors(bool on = true);
+
+    // Escape control bytes (new lines and alike) of messages, context
+    // and fields in CLI and file rows, so every record is single line.
+    // Syslog text and JSON are always escaped
+    logger& set_sanitize_text(bool on = true);
 
     logger& set_level(int filter = logger::level_debug);
     logger& set_level_from_environment(const char* var_name);
 
     int level_filter() const
     {
-        return _level_filter;
+        return config_guard(*this)->level_filter;
     }
 
     logger& set_details(int filter = logger::details_without_app_name);
@@ -99,35 +323,222 @@ public:
 
     int details_filter() const
     {
-        return _details_filter;
+        return config_guard(*this)->details_filter;
+    }
+
+    // Level filter for single destination (in order of adding)
+    logger& set_destination_level(size_t index, int filter);
+    int destination_level_filter(size_t index) const;
+
+    // Apply 'key=value' lines (# for comments):
+    //   level=<filter or trace|debug|info|warning|error>
+    //   details=<filter>
+    //   destination.<index>.level=<filter or name>
+    //   site.<on|off|level>=<site query>
+    // Site rules of previously loaded config are replaced
+    logger& load_config(const std::string& path);
+
+    // Reload config file if it is rewritten (inotify) or if reload_signal
+    // is received. Empty path to reload by signal only (config epoch
+    // is changed only). Zero signal to watch file only
+    logger& watch_config(const std::string& path, int reload_signal = SIGHUP);
+
+    // Switch call sites matched by query (see log_site.h) on (written
+    // regardless of level filter), off or back to level filter
+    logger& set_sites(const std::string& query, site_mode mode);
+    // Drop all site rules
+    logger& reset_sites();
+
+    // Count hits, filtered hits and message bytes of LOG_* call sites.
+    // Time is measured for every sample_period-th hit of thread
+    // (never if zero)
+    logger& set_site_profiling(bool on = true, uint32_t sample_period = 16);
+    // Top sites by every metric of set_site_profiling
+    site_profile dump_site_profile(size_t top = 10) const;
+
+    // Incremented by every change of level, details or destination levels
+    uint32_t config_epoch() const
+    {
+        return config_guard(*this)->epoch;
     }
 
+    // Lock-free snapshot of self-metrics
+    stats_snapshot stats() const;
+    // Write stats as info record periodically. Zero to disable
+    logger& set_stats_period(std::chrono::milliseconds period);
+
     void lock();
     void unlock();
 
     logger& add_destination(log_handler_type&& handler);
 
+    // Destination composed at compile time (see log_pipeline.h)
+    template <typename... Stages>
+    logger& add_destination(pipeline<Stages...>&& sink)
+    {
+        using pipeline_type = pipeline<Stages...>;
+
+        destination item;
+        item.write = [](void* state, const log_message& msg, int details_filter) {
+            (*static_cast<pipeline_type*>(state))(msg, details_filter);
+        };
+        item.flush = [](void* state) {
+            static_cast<pipeline_type*>(state)->flush();
+        };
+        item.state = std::make_shared<pipeline_type>(std::move(sink));
+        return add_appender(std::move(item));
+    }
+
     void write(log_message& msg);
 
+    // Hit of site switched off (see LOG_* macros). Counted by site profiling
+    void skip(log_site& site);
+
+    // Wait for records accepted before are written (for async mode)
+    void flush();
+
     size_t get_appenders_count() const
     {
         return _appenders.size();
     }
 
+    bool is_async() const
+    {
+        return _async != nullptr;
+    }
+
+    // Descriptor (eventfd) readable while records wait for drain
+    // in external drain mode. -1 in other modes
+    int drain_fd() const;
+
+    // Writes waiting records up to max_records or until max_time
+    // elapsed (if not zero) for external drain mode. Descriptor is
+    // signaled again if records remain. Returns written records
+    size_t drain(size_t max_records = std::numeric_limits<size_t>::max(),
+                 std::chrono::microseconds max_time = std::chrono::microseconds::zero());
+
+    // Process name in records
+    static const std::string& application_name();
+
 private:
+    // Destination called through plain pointers. Handler
+    // (std::function) and pipeline are kept as state
+    struct destination
+    {
+        void (*write)(void* state, const log_message& msg, int details_filter) = nullptr;
+        // Optional
+        void (*flush)(void* state) = nullptr;
+        std::shared_ptr<void> state;
+    };
+
+    logger& add_appender(destination&& item);
+    void flush_appenders();
+
     void add_cli_destination();
     void add_syslog_destination();
+    void add_json_destination();
+    void add_shm_destination(const std::string& name, size_t capacity);
+    void add_file_destination(const std::string& path, const file_options& options);
+
+    friend class buffered_scope;
+
+    // Filters are published together as immutable state by single
+    // pointer store, so record is filtered and dispatched by the same
+    // state. Replaced state is freed by the next update unless some
+    // thread still reads it (see config_guard)
+    struct config_state
+    {
+        uint32_t epoch = 0;
+        int level_filter = 0;
+        int details_filter = 0;
+        // By destination index
+        std::vector<int> destination_levels;
+    };
+
+    // Pins current state in reader slot of thread while alive
+    // (hazard pointer). Nested guards of thread share the outer state
+    class config_guard
+    {
+    public:
+        explicit config_guard(const logger& log);
+        ~config_guard();
+
+        config_guard(const config_guard&) = delete;
+        config_guard& operator=(const config_guard&) = delete;
+
+        const config_state& operator*() const
+        {
+            return *_state;
+        }
+
+        const config_state* operator->() const
+        {
+            return _state;
+        }
+
+    private:
+        const config_state* _state;
+    };
+
+    // For updaters only (under _config_mutex)
+    const config_state& current_config() const
+    {
+        return *_config.load(std::memory_order_acquire);
+    }
+
+    // Record passed level filter
+    void write_accepted(log_message& msg);
+    void write_accepted(log_message& msg, const config_state& config);
+    void dispatch(const log_message& msg, const config_state& config);
+    void dispatch_urgent(const log_message& msg, const config_state& config);
+    void emit_stats_if_expired(uint64_t timestamp);
+
+    // Publishes copy of current state changed by 'change' with the next epoch.
+    // Frees replaced states that aren't pinned by readers
+    void update_config(const std::function<void(config_state&)>& change);
+    void update_cli_renderer();
+    void reload_config();
 
 private:
-    std::vector<log_handler_type> _appenders;
+    std::vector<destination> _appenders;
     bool _added_cli_destination = false;
     bool _added_syslog_destination = false;
+    bool _added_json_destination = false;
+    bool _added_shm_destination = false;
+    bool _added_file_destination = false;
 
     std::string _time_format = logger::default_time_format;
-    int _level_filter = logger::level_trace;
-    int _details_filter = logger::details_without_app_name;
+    std::atomic<const config_state*> _config;
+    // Serializes updaters, owns current and pinned replaced states
+    std::mutex _config_mutex;
+    std::vector<std::unique_ptr<config_state>> _config_states;
+    // Row renderer of CLI and file destinations generated for
+    // current details (see text_writer.h). Selected by update_config
+    using cli_renderer_type = void (*)(std::string&, const log_message&, clock_type::time_point,
+                                       const std::string&, const std::string&, bool);
+    std::atomic<cli_renderer_type> _cli_renderer;
     std::atomic_bool _logs_on;
+    std::atomic_bool _sync_errors;
+    std::atomic_bool _sanitize_text;
     std::mutex _mutex_for_row;
+
+    std::unique_ptr<async_writer> _async;
+    std::unique_ptr<file_writer> _file_writer;
+
+    std::unique_ptr<logger_stats> _stats;
+    std::atomic<uint64_t> _stats_period_ticks;
+    std::atomic<uint64_t> _next_stats_ticks;
+
+    std::atomic_bool _site_profiling;
+    std::atomic<uint32_t> _site_sample_period;
+
+    std::string _config_path;
+    // Destination levels and site rules of the last loaded config,
+    // replaced by reload
+    std::vector<size_t> _config_destinations;
+    std::vector<std::string> _config_site_queries;
+    std::mutex _load_config_mutex;
+    std::unique_ptr<config_watcher> _config_watcher;
 };
 
 } // namespace server_lib
@@ -9,6 +9,8 @@
 #include <sstream>
 
 #include "logger.h"
+#include "log_scope.h"
+#include "log_site.h"
 #include "macro.h"
 #include "platform_config.h"
 
@@ -46,16 +48,49 @@ public:
 
 #define SRV_LOG_NS_ server_lib
 
-#define LOG_LOG(LEVEL, FILE, LINE, FUNC, ARG)                     \
-    SRV_EXPAND_MACRO(                                             \
-        SRV_MULTILINE_MACRO_BEGIN {                               \
-            SRV_LOG_NS_::logger::log_message msg;                 \
-            msg.context.lv = LEVEL;                               \
-            msg.context.file = SRV_LOG_NS_::trim_file_path(FILE); \
-            msg.context.line = LINE;                              \
-            msg.context.method = FUNC;                            \
-            msg.message << ARG;                                   \
-            SRV_LOG_NS_::logger::instance().write(msg);           \
+// Site switched off (see log_site.h) is skipped before message is built
+// (its hit is counted only)
+#define LOG_LOG(LEVEL, FILE, LINE, FUNC, ARG)                                     \
+    SRV_EXPAND_MACRO(                                                             \
+        SRV_MULTILINE_MACRO_BEGIN {                                               \
+            static SRV_LOG_NS_::log_site log_site_(LEVEL, FILE, LINE, FUNC);      \
+            if (!log_site_.switched_off())                                        \
+            {                                                                     \
+                SRV_LOG_NS_::logger::log_message msg;                             \
+                msg.context.lv = LEVEL;                                           \
+                msg.context.file = SRV_LOG_NS_::trim_file_path(FILE);             \
+                msg.context.line = LINE;                                          \
+                msg.context.method = FUNC;                                        \
+                msg.context.site = &log_site_;                                    \
+                msg << ARG;                                                       \
+                SRV_LOG_NS_::logger::instance().write(msg);                       \
+            }                                                                     \
+            else                                                                  \
+            {                                                                     \
+                SRV_LOG_NS_::logger::instance().skip(log_site_);                  \
+            }                                                                     \
+        } SRV_MULTILINE_MACRO_END)
+
+#define LOG_LOG_KV(LEVEL, FILE, LINE, FUNC, ARG, ...)                             \
+    SRV_EXPAND_MACRO(                                                             \
+        SRV_MULTILINE_MACRO_BEGIN {                                               \
+            static SRV_LOG_NS_::log_site log_site_(LEVEL, FILE, LINE, FUNC);      \
+            if (!log_site_.switched_off())                                        \
+            {                                                                     \
+                SRV_LOG_NS_::logger::log_message msg;                             \
+                msg.context.lv = LEVEL;                                           \
+                msg.context.file = SRV_LOG_NS_::trim_file_path(FILE);             \
+                msg.context.line = LINE;                                          \
+                msg.context.method = FUNC;                                        \
+                msg.context.site = &log_site_;                                    \
+                msg << ARG;                                                       \
+                msg.add_fields(__VA_ARGS__);                                      \
+                SRV_LOG_NS_::logger::instance().write(msg);                       \
+            }                                                                     \
+            else                                                                  \
+            {                                                                     \
+                SRV_LOG_NS_::logger::instance().skip(log_site_);                  \
+            }                                                                     \
         } SRV_MULTILINE_MACRO_END)
 
 #define LOG_TRACE(ARG) LOG_LOG(SRV_LOG_NS_::logger::level::trace, __FILE__, __LINE__, LOG_FUNCTION_NAME, ARG)
@@ -65,6 +100,14 @@ public:
 #define LOG_ERROR(ARG) LOG_LOG(SRV_LOG_NS_::logger::level::error, __FILE__, __LINE__, LOG_FUNCTION_NAME, ARG)
 #define LOG_FATAL(ARG) LOG_LOG(SRV_LOG_NS_::logger::level::fatal, __FILE__, __LINE__, LOG_FUNCTION_NAME, ARG)
 
+// Structured records: LOG_INFO_KV("request done", ll::kv("latency_us", x), ll::kv("user", id))
+#define LOG_TRACE_KV(ARG, ...) LOG_LOG_KV(SRV_LOG_NS_::logger::level::trace, __FILE__, __LINE__, LOG_FUNCTION_NAME, ARG, __VA_ARGS__)
+#define LOG_DEBUG_KV(ARG, ...) LOG_LOG_KV(SRV_LOG_NS_::logger::level::debug, __FILE__, __LINE__, LOG_FUNCTION_NAME, ARG, __VA_ARGS__)
+#define LOG_INFO_KV(ARG, ...) LOG_LOG_KV(SRV_LOG_NS_::logger::level::info, __FILE__, __LINE__, LOG_FUNCTION_NAME, ARG, __VA_ARGS__)
+#define LOG_WARN_KV(ARG, ...) LOG_LOG_KV(SRV_LOG_NS_::logger::level::warning, __FILE__, __LINE__, LOG_FUNCTION_NAME, ARG, __VA_ARGS__)
+#define LOG_ERROR_KV(ARG, ...) LOG_LOG_KV(SRV_LOG_NS_::logger::level::error, __FILE__, __LINE__, LOG_FUNCTION_NAME, ARG, __VA_ARGS__)
+#define LOG_FATAL_KV(ARG, ...) LOG_LOG_KV(SRV_LOG_NS_::logger::level::fatal, __FILE__, __LINE__, LOG_FUNCTION_NAME, ARG, __VA_ARGS__)
+
 #define LOGC_TRACE(ARG) LOG_TRACE(LOG_CONTEXT << ARG)
 #define LOGC_DEBUG(ARG) LOG_DEBUG(LOG_CONTEXT << ARG)
 #define LOGC_INFO(ARG) LOG_INFO(LOG_CONTEXT << ARG)
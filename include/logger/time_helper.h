@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <ctime>
 #include <string>
 #include <stdexcept>
 
@@ -10,4 +12,11 @@ namespace server_lib {
 time_t from_iso_string(const std::string& formatted, const char* format, bool should_utc = true);
 std::string to_iso_string(const time_t, const char* format, bool should_utc = true);
 
+// Allocation-free versions. Formats of %Y %m %d %H %M %S and separators
+// (like default_time_format) are handled without libc, local time uses
+// cached UTC offset. Other formats fall back to libc.
+// Return 0 or error code: EINVAL - can't parse/format, ERANGE - buffer is too small
+int parse_iso_time(const char* formatted, size_t size, const char* format, time_t& result, bool should_utc = true);
+int format_iso_time(const time_t t, const char* format, char* buffer, size_t capacity, size_t& size, bool should_utc = true);
+
 } // namespace server_lib
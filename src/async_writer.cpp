@@ -0,0 +1,604 @@
+#include "async_writer.h"
+#include "record_ring.h"
+#include "queued_record.h"
+#include "tsc_clock.h"
+#include "thread_affinity.h"
+
+#include <logger/platform_config.h>
+#include <logger/asserts.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <limits>
+#include <tuple>
+
+namespace server_lib {
+
+namespace {
+    // Ring bytes per record of queue_capacity
+    const size_t record_size_hint = 256;
+} // namespace
+
+struct producer_queue
+{
+    producer_queue(size_t capacity, size_t home_)
+        : ring(capacity * record_size_hint, capacity)
+        , home(home_)
+    {
+    }
+
+    ~producer_queue()
+    {
+        ring.consume(release_queued_record, std::numeric_limits<size_t>::max());
+    }
+
+    bool try_claim()
+    {
+        return !busy.test_and_set(std::memory_order_acquire);
+    }
+
+    void release()
+    {
+        busy.clear(std::memory_order_release);
+    }
+
+    record_ring ring;
+    // Preferred flusher
+    const size_t home;
+    // Some flusher is draining this queue
+    std::atomic_flag busy = ATOMIC_FLAG_INIT;
+    // Producer thread has exited
+    std::atomic_bool orphaned { false };
+
+    // Written by producer only. Writer's maximum is updated
+    // when this one grows only
+    std::atomic<uint64_t> high_water { 0 };
+};
+
+namespace {
+    const size_t drain_batch_size = 256;
+    // Deadline of external drain is checked every batch
+    const size_t timed_drain_batch_size = 32;
+    // Queue depth is sampled every 64 records
+    const size_t high_water_sample_mask = 63;
+    const std::chrono::microseconds idle_timeout(5000);
+
+    std::atomic<uint64_t> s_generation_counter(0);
+
+    struct this_thread_queue
+    {
+        std::shared_ptr<producer_queue> queue;
+        uint64_t generation = 0;
+
+        ~this_thread_queue()
+        {
+            release();
+        }
+
+        void release()
+        {
+            if (queue)
+            {
+                queue->orphaned.store(true, std::memory_order_release);
+                queue.reset();
+            }
+        }
+    };
+
+    thread_local this_thread_queue s_this_thread_queue;
+
+} // namespace
+
+async_writer::async_writer(const logger::async_options& options, handler_type&& handler)
+    : _options(options)
+    , _generation(++s_generation_counter)
+    , _handler(std::move(handler))
+{
+    SRV_ASSERT(_options.flushers > 0, "Flusher is required");
+    SRV_ASSERT(_options.queue_capacity > 0, "Queue capacity is required");
+    for (auto cpu : _options.cpu_affinity)
+    {
+        SRV_ASSERT(cpu >= 0 && cpu < CPU_SETSIZE, "Invalid CPU");
+    }
+
+    if (_options.external_drain)
+    {
+        SRV_ASSERT(_options.reorder_window.count() == 0, "Reorder window requires merger thread");
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        _drain_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        SRV_ASSERT(_drain_fd >= 0, "Can't create eventfd");
+#else
+        SRV_ERROR("External drain requires eventfd");
+#endif
+        return;
+    }
+
+    if (_options.numa_affinity && _options.cpu_affinity.empty())
+        _numa_nodes = numa_topology::instance().nodes_count();
+
+    if (_options.reorder_window.count() > 0)
+    {
+        _flushers.emplace_back(&async_writer::merger_loop, this);
+        return;
+    }
+
+    _flushers.reserve(_options.flushers);
+    for (size_t ci = 0; ci < _options.flushers; ++ci)
+    {
+        _flushers.emplace_back(&async_writer::flusher_loop, this, ci);
+    }
+}
+
+async_writer::~async_writer()
+{
+    if (_drain_fd >= 0)
+    {
+        // Records application hasn't drained
+        drain_external(std::numeric_limits<size_t>::max(), std::chrono::microseconds::zero());
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        close(_drain_fd);
+#endif
+        return;
+    }
+
+    _stop = true;
+    {
+        std::lock_guard<std::mutex> lock(_idle_mutex);
+    }
+    _idle_cond.notify_all();
+    for (auto& flusher : _flushers)
+    {
+        flusher.join();
+    }
+}
+
+void async_writer::push(message_type& msg)
+{
+    auto& local = s_this_thread_queue;
+    if (!local.queue || local.generation != _generation)
+    {
+        local.release();
+        local.queue = register_this_thread();
+        local.generation = _generation;
+    }
+
+    auto& queue = *local.queue;
+    auto& ring = queue.ring;
+
+    // Huge record goes to heap to keep its place in queue
+    // (and in merge by time)
+    size_t size = queued_record_size(msg);
+    const bool spilled = size > ring.max_record_size();
+    if (spilled)
+        size = sizeof(queued_record_header);
+
+    char* record = nullptr;
+    while ((record = ring.reserve(size)) == nullptr)
+    {
+        if (_options.drop_on_overflow)
+        {
+            _drops.fetch_add(1, std::memory_order_relaxed);
+            wake_flushers();
+            return;
+        }
+        help_flushers();
+    }
+    if (spilled)
+        encode_spilled_record(msg, record);
+    else
+        encode_queued_record(msg, record);
+    ring.commit();
+
+    if ((ring.tail_position() & high_water_sample_mask) == 0)
+    {
+        const uint64_t depth = ring.size();
+        if (depth > queue.high_water.load(std::memory_order_relaxed))
+        {
+            queue.high_water.store(depth, std::memory_order_relaxed);
+            auto high_water = _high_water.load(std::memory_order_relaxed);
+            while (depth > high_water && !_high_water.compare_exchange_weak(high_water, depth, std::memory_order_relaxed))
+                ;
+        }
+    }
+
+    if (_drain_fd >= 0)
+        signal_drain();
+    else if (_idle_flushers.load(std::memory_order_relaxed))
+        wake_flushers();
+}
+
+void async_writer::flush()
+{
+    std::vector<producer_queue_ptr> queues;
+    {
+        std::lock_guard<std::mutex> lock(_registry_mutex);
+        queues = _queues;
+    }
+
+    _urgent.fetch_add(1, std::memory_order_relaxed);
+    for (const auto& queue : queues)
+    {
+        const auto target = queue->ring.tail_position();
+        while (queue->ring.head_position() < target)
+        {
+            help_flushers();
+        }
+    }
+    _urgent.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void async_writer::flush_this_thread()
+{
+    auto& local = s_this_thread_queue;
+    if (!local.queue || local.generation != _generation)
+        return;
+
+    auto& ring = local.queue->ring;
+    const auto target = ring.tail_position();
+    if (ring.head_position() >= target)
+        return;
+
+    _urgent.fetch_add(1, std::memory_order_relaxed);
+    while (ring.head_position() < target)
+    {
+        help_flushers();
+    }
+    _urgent.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void async_writer::collect_stats(logger::stats_snapshot& snapshot) const
+{
+    snapshot.queue_high_water = std::max(snapshot.queue_high_water, _high_water.load(std::memory_order_relaxed));
+    snapshot.drops += _drops.load(std::memory_order_relaxed);
+}
+
+async_writer::producer_queue_ptr async_writer::register_this_thread()
+{
+    std::lock_guard<std::mutex> lock(_registry_mutex);
+
+    // Called by producer thread, so ring pages are on its node
+    size_t home = _next_home++ % _options.flushers;
+    if (_numa_nodes > 1)
+    {
+        // Flushers node, node + nodes_count, ... run on node of producer
+        const size_t node = numa_topology::instance().current_node();
+        if (node < _options.flushers)
+        {
+            const size_t on_node = (_options.flushers - node + _numa_nodes - 1) / _numa_nodes;
+            home = node + (home % on_node) * _numa_nodes;
+        }
+    }
+
+    auto queue = std::make_shared<producer_queue>(_options.queue_capacity, home);
+    _queues.push_back(queue);
+    _registry_version.fetch_add(1, std::memory_order_release);
+    return queue;
+}
+
+void async_writer::pin_this_thread(size_t index)
+{
+    // Buffers of thread are allocated after pinning so they are node local
+    if (!_options.cpu_affinity.empty())
+    {
+        set_this_thread_affinity({ _options.cpu_affinity[index % _options.cpu_affinity.size()] });
+    }
+    else if (_numa_nodes > 1)
+    {
+        set_this_thread_affinity(numa_topology::instance().node_cpus(index % _numa_nodes));
+    }
+}
+
+void async_writer::flusher_loop(size_t index)
+{
+    if (!_options.thread_name_prefix.empty())
+        set_this_thread_name(_options.thread_name_prefix + "-flusher-" + std::to_string(index));
+    pin_this_thread(index);
+
+    std::vector<producer_queue_ptr> queues;
+    uint64_t version = 0;
+    bool has_snapshot = false;
+
+    for (;;)
+    {
+        refresh_snapshot(queues, version, has_snapshot);
+
+        size_t handled = 0;
+        bool has_orphaned = false;
+
+        // Own queues at first pass, steal from others at second one
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            for (const auto& queue : queues)
+            {
+                if ((queue->home == index) != (pass == 0))
+                    continue;
+
+                if (queue->ring.empty())
+                {
+                    if (queue->orphaned.load(std::memory_order_acquire) && queue->ring.empty())
+                        has_orphaned = true;
+                    continue;
+                }
+
+                if (!queue->try_claim())
+                    continue;
+
+                handled += drain(*queue, drain_batch_size);
+                queue->release();
+            }
+        }
+
+        if (has_orphaned)
+            remove_orphaned();
+
+        if (handled)
+            continue;
+
+        // Nothing to steal. Other flushers finish queues they claimed
+        if (_stop.load(std::memory_order_acquire))
+            break;
+
+        wait_idle(idle_timeout);
+    }
+}
+
+void async_writer::merger_loop()
+{
+    if (!_options.thread_name_prefix.empty())
+        set_this_thread_name(_options.thread_name_prefix + "-merger");
+    pin_this_thread(0);
+
+    // (timestamp, id) of queue front. Min-heap
+    using heap_item = std::tuple<uint64_t, unsigned long, producer_queue*>;
+    auto heap_greater = [](const heap_item& a, const heap_item& b) {
+        return a > b;
+    };
+    auto make_item = [](producer_queue* queue, const char* front) {
+        const auto& header = queued_record_of(front);
+        return std::make_tuple(header.timestamp, static_cast<unsigned long>(header.id), queue);
+    };
+    message_type msg;
+
+    auto& clock = tsc_clock::instance();
+    const uint64_t window_ticks = clock.to_ticks(_options.reorder_window);
+    auto get_deadline = [&clock, window_ticks]() -> uint64_t {
+        const uint64_t now = clock.now();
+        return (now > window_ticks) ? (now - window_ticks) : 0;
+    };
+
+    std::vector<producer_queue_ptr> queues;
+    uint64_t version = 0;
+    bool has_snapshot = false;
+    std::vector<heap_item> heap;
+
+    for (;;)
+    {
+        refresh_snapshot(queues, version, has_snapshot);
+
+        const bool stop = _stop.load(std::memory_order_acquire);
+
+        heap.clear();
+        bool has_orphaned = false;
+        for (const auto& queue : queues)
+        {
+            auto front = queue->ring.front();
+            if (front)
+                heap.push_back(make_item(queue.get(), front));
+            else if (queue->orphaned.load(std::memory_order_acquire) && queue->ring.empty())
+                has_orphaned = true;
+        }
+        std::make_heap(heap.begin(), heap.end(), heap_greater);
+
+        // Record is safe to write only if it is older than window.
+        // Producer captures timestamp before it registers queue,
+        // so fronts of known queues do not bound records to come
+        auto deadline = get_deadline();
+        size_t handled = 0;
+        while (!heap.empty())
+        {
+            const auto& top = heap.front();
+            const auto hurry = stop || _urgent.load(std::memory_order_relaxed) > 0;
+            if (!hurry && std::get<0>(top) > deadline)
+                break;
+
+            auto queue = std::get<2>(top);
+            std::pop_heap(heap.begin(), heap.end(), heap_greater);
+            heap.pop_back();
+
+            decode_queued_record(queue->ring.front(), msg);
+            _handler(msg);
+            queue->ring.pop();
+
+            auto front = queue->ring.front();
+            if (front)
+            {
+                heap.push_back(make_item(queue, front));
+                std::push_heap(heap.begin(), heap.end(), heap_greater);
+            }
+
+            if (++handled % drain_batch_size == 0)
+                deadline = get_deadline();
+        }
+
+        if (has_orphaned)
+            remove_orphaned();
+
+        if (handled)
+            continue;
+
+        if (stop && heap.empty())
+            break;
+
+        auto timeout = idle_timeout;
+        if (!heap.empty())
+        {
+            const uint64_t ticks_per_us = std::max<uint64_t>(clock.to_ticks(std::chrono::microseconds(1)), 1);
+            std::chrono::microseconds until_deadline((std::get<0>(heap.front()) - deadline) / ticks_per_us);
+            timeout = std::min(timeout, std::max(until_deadline, std::chrono::microseconds(1)));
+        }
+        wait_idle(timeout);
+    }
+}
+
+void async_writer::refresh_snapshot(std::vector<producer_queue_ptr>& queues, uint64_t& version, bool& has_snapshot)
+{
+    if (!has_snapshot || _registry_version.load(std::memory_order_acquire) != version)
+    {
+        std::lock_guard<std::mutex> lock(_registry_mutex);
+        queues = _queues;
+        version = _registry_version.load(std::memory_order_relaxed);
+        has_snapshot = true;
+    }
+}
+
+void async_writer::wait_idle(std::chrono::microseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(_idle_mutex);
+    _idle_flushers.fetch_add(1, std::memory_order_relaxed);
+    if (!_stop.load(std::memory_order_acquire))
+        _idle_cond.wait_for(lock, timeout);
+    _idle_flushers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+size_t async_writer::drain(producer_queue& queue, size_t max_records)
+{
+    // Reused by flusher to not allocate strings per record
+    thread_local message_type msg;
+    return queue.ring.consume([this](const char* record) {
+        decode_queued_record(record, msg);
+        _handler(msg);
+    },
+                              max_records);
+}
+
+void async_writer::remove_orphaned()
+{
+    std::lock_guard<std::mutex> lock(_registry_mutex);
+
+    auto it = _queues.begin();
+    bool removed = false;
+    while (it != _queues.end())
+    {
+        const auto& queue = *it;
+        if (queue->orphaned.load(std::memory_order_acquire) && queue->ring.empty())
+        {
+            it = _queues.erase(it);
+            removed = true;
+        }
+        else
+            ++it;
+    }
+    if (removed)
+        _registry_version.fetch_add(1, std::memory_order_release);
+}
+
+void async_writer::wake_flushers()
+{
+    _idle_cond.notify_one();
+}
+
+void async_writer::help_flushers()
+{
+    if (_drain_fd >= 0)
+        drain_external(std::numeric_limits<size_t>::max(), std::chrono::microseconds::zero());
+    else
+        wake_flushers();
+    std::this_thread::yield();
+}
+
+void async_writer::signal_drain()
+{
+    // Exchange orders it after commit of record, so drain
+    // that has reset flag sees the record
+    if (_drain_signaled.exchange(true))
+        return;
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    const uint64_t one = 1;
+    while (write(_drain_fd, &one, sizeof(one)) < 0 && errno == EINTR)
+        ;
+#endif
+}
+
+size_t async_writer::drain_external(size_t max_records, std::chrono::microseconds max_time)
+{
+    SRV_ASSERT(_drain_fd >= 0, "Drain requires external_drain mode");
+
+    using clock = std::chrono::steady_clock;
+    const bool timed = max_time.count() > 0;
+    const auto deadline = timed ? clock::now() + max_time : clock::time_point();
+    const size_t batch_size = timed ? timed_drain_batch_size : drain_batch_size;
+
+    // Descriptor is read before flag is reset, so signal of concurrent
+    // push is either consumed with flag still set (and the record is seen
+    // below) or left readable. Records committed after reset signal again
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    uint64_t value;
+    while (read(_drain_fd, &value, sizeof(value)) < 0 && errno == EINTR)
+        ;
+#endif
+    _drain_signaled.exchange(false);
+
+    std::vector<producer_queue_ptr> queues;
+    {
+        std::lock_guard<std::mutex> lock(_registry_mutex);
+        queues = _queues;
+    }
+    if (queues.empty())
+        return 0;
+
+    // Every drain starts from the next queue, so busy
+    // producer doesn't starve others under small budget
+    const size_t first = _next_drain.fetch_add(1, std::memory_order_relaxed);
+
+    size_t handled = 0;
+    bool has_orphaned = false;
+    bool exhausted = false;
+    for (bool progress = true; progress && !exhausted;)
+    {
+        progress = false;
+        for (size_t ci = 0; ci < queues.size() && !exhausted; ++ci)
+        {
+            auto& queue = *queues[(first + ci) % queues.size()];
+            if (queue.ring.empty())
+            {
+                if (queue.orphaned.load(std::memory_order_acquire) && queue.ring.empty())
+                    has_orphaned = true;
+                continue;
+            }
+
+            // Drained by another thread
+            if (!queue.try_claim())
+                continue;
+
+            const size_t count = drain(queue, std::min(batch_size, max_records - handled));
+            queue.release();
+
+            handled += count;
+            progress = progress || count > 0;
+            exhausted = handled >= max_records || (timed && clock::now() >= deadline);
+        }
+    }
+
+    if (has_orphaned)
+        remove_orphaned();
+
+    for (const auto& queue : queues)
+    {
+        if (!queue->ring.empty())
+        {
+            signal_drain();
+            break;
+        }
+    }
+    return handled;
+}
+
+} // namespace server_lib
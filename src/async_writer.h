@@ -0,0 +1,114 @@
+#pragma once
+
+#include <logger/logger.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace server_lib {
+
+struct producer_queue;
+
+/**
+ * \brief Backend of asynchronous logging
+ *
+ * Every producer thread owns SPSC queue. Flusher threads
+ * take non-empty queues (own first then steal others).
+ * The only one flusher can drain the same queue at a time
+ * so records of the same thread keep their order.
+ *
+ * With reorder window the single flusher merges queues
+ * by record time (k-way heap merge).
+ *
+ * With NUMA affinity flusher N runs on node N % nodes_count and
+ * producer queue is drained by flusher of producer's node.
+ *
+ * With external drain there are no flushers. Push signals eventfd
+ * (once until the next drain) and application calls drain_external
+ * from its event loop. Waiting threads (flush, full queue) drain
+ * queues themselves.
+ */
+class async_writer
+{
+public:
+    using message_type = logger::log_message;
+    // Record could be changed (rendered lazy parts)
+    using handler_type = std::function<void(message_type&)>;
+
+    async_writer(const logger::async_options& options, handler_type&& handler);
+    ~async_writer();
+
+    void push(message_type& msg);
+
+    // Wait for records pushed before this call are handled
+    void flush();
+    // The same for records of the calling thread only
+    void flush_this_thread();
+
+    void collect_stats(logger::stats_snapshot& snapshot) const;
+
+    // -1 if not external drain
+    int drain_fd() const
+    {
+        return _drain_fd;
+    }
+
+    // Handles up to max_records (or until max_time elapsed if not zero).
+    // At least one batch is handled if any. Signals again if records remain
+    size_t drain_external(size_t max_records, std::chrono::microseconds max_time);
+
+private:
+    using producer_queue_ptr = std::shared_ptr<producer_queue>;
+
+    producer_queue_ptr register_this_thread();
+    void pin_this_thread(size_t index);
+    void flusher_loop(size_t index);
+    void merger_loop();
+    void refresh_snapshot(std::vector<producer_queue_ptr>& queues, uint64_t& version, bool& has_snapshot);
+    void wait_idle(std::chrono::microseconds timeout);
+    size_t drain(producer_queue& queue, size_t max_records);
+    void remove_orphaned();
+    void wake_flushers();
+    // Wakes flushers or drains queues if there are no ones
+    void help_flushers();
+    void signal_drain();
+
+private:
+    const logger::async_options _options;
+    const uint64_t _generation;
+    handler_type _handler;
+
+    std::mutex _registry_mutex;
+    std::vector<producer_queue_ptr> _queues;
+    std::atomic<uint64_t> _registry_version { 0 };
+    size_t _next_home = 0;
+    // Flushers are spread over NUMA nodes if more than one
+    size_t _numa_nodes = 1;
+    // Stats of all queues (including removed ones) read without
+    // registry lock. Drops are rare and maximum rarely grows
+    std::atomic<uint64_t> _high_water { 0 };
+    std::atomic<uint64_t> _drops { 0 };
+
+    std::mutex _idle_mutex;
+    std::condition_variable _idle_cond;
+    std::atomic<size_t> _idle_flushers { 0 };
+
+    std::atomic_bool _stop { false };
+    // Merger doesn't wait for reorder window while somebody flushes
+    std::atomic<size_t> _urgent { 0 };
+    std::vector<std::thread> _flushers;
+
+    int _drain_fd = -1;
+    // Descriptor was signaled after the last drain
+    std::atomic_bool _drain_signaled { false };
+    // The first queue of the next drain (round robin)
+    std::atomic<size_t> _next_drain { 0 };
+};
+
+} // namespace server_lib
@@ -0,0 +1,199 @@
+#include "config_watcher.h"
+#include "logging_trace.h"
+#include "thread_affinity.h"
+
+#include <logger/platform_config.h>
+#include <logger/asserts.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace server_lib {
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+namespace {
+    std::atomic<int> s_signal_wake_fd(-1);
+    struct sigaction s_previous_action;
+
+    void on_reload_signal(int)
+    {
+        int fd = s_signal_wake_fd.load();
+        if (fd >= 0)
+        {
+            // Interrupted code could check errno
+            const int saved_errno = errno;
+            uint64_t value = 1;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-result"
+            write(fd, &value, sizeof(value));
+#pragma GCC diagnostic pop
+            errno = saved_errno;
+        }
+    }
+
+    std::string directory_of(const std::string& path)
+    {
+        auto pos = path.rfind('/');
+        if (pos == std::string::npos)
+            return ".";
+        if (pos == 0)
+            return "/";
+        return path.substr(0, pos);
+    }
+
+    std::string file_name_of(const std::string& path)
+    {
+        auto pos = path.rfind('/');
+        if (pos == std::string::npos)
+            return path;
+        return path.substr(pos + 1);
+    }
+} // namespace
+
+config_watcher::config_watcher(const std::string& path, int reload_signal, reload_type&& reload)
+    : _path(path)
+    , _reload_signal(reload_signal)
+    , _reload(std::move(reload))
+{
+    _wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    SRV_ASSERT(_wake_fd >= 0, "Can't create eventfd");
+
+    if (!_path.empty())
+    {
+        _inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+        SRV_ASSERT(_inotify_fd >= 0, "Can't init inotify");
+
+        // Watch directory to catch replacing file by editors
+        auto dir = directory_of(_path);
+        if (inotify_add_watch(_inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            close(_inotify_fd);
+            close(_wake_fd);
+            SRV_ERROR("Can't watch config directory");
+        }
+    }
+
+    if (_reload_signal > 0)
+    {
+        s_signal_wake_fd = _wake_fd;
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = on_reload_signal;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(_reload_signal, &action, &s_previous_action);
+    }
+
+    _thread = std::thread(&config_watcher::watch_loop, this);
+}
+
+config_watcher::~config_watcher()
+{
+    if (_reload_signal > 0)
+    {
+        sigaction(_reload_signal, &s_previous_action, nullptr);
+        s_signal_wake_fd = -1;
+    }
+
+    _stop = true;
+    uint64_t value = 1;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-result"
+    write(_wake_fd, &value, sizeof(value));
+#pragma GCC diagnostic pop
+    _thread.join();
+
+    if (_inotify_fd >= 0)
+        close(_inotify_fd);
+    close(_wake_fd);
+}
+
+void config_watcher::watch_loop()
+{
+    set_this_thread_name("ll-config");
+
+    const auto file_name = file_name_of(_path);
+
+    pollfd fds[2];
+    fds[0].fd = _wake_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = _inotify_fd;
+    fds[1].events = POLLIN;
+    const nfds_t fds_count = (_inotify_fd >= 0) ? 2 : 1;
+
+    alignas(inotify_event) char buff[4096];
+
+    while (!_stop.load())
+    {
+        if (poll(fds, fds_count, -1) <= 0)
+            continue;
+
+        bool should_reload = false;
+
+        if (fds[0].revents & POLLIN)
+        {
+            uint64_t value = 0;
+            if (read(_wake_fd, &value, sizeof(value)) > 0)
+                should_reload = true;
+        }
+
+        if (fds_count > 1 && (fds[1].revents & POLLIN))
+        {
+            ssize_t ln = 0;
+            while ((ln = read(_inotify_fd, buff, sizeof(buff))) > 0)
+            {
+                for (char* p = buff; p < buff + ln;)
+                {
+                    auto event = reinterpret_cast<inotify_event*>(p);
+                    if (event->len && file_name == event->name)
+                        should_reload = true;
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+
+        if (_stop.load())
+            break;
+
+        if (should_reload)
+        {
+            try
+            {
+                _reload();
+            }
+            catch (std::exception& e)
+            {
+                SRV_TRACE_SIGNAL(e.what());
+            }
+        }
+    }
+}
+#else // SERVER_LIB_PLATFORM_LINUX
+config_watcher::config_watcher(const std::string& path, int reload_signal, reload_type&& reload)
+    : _path(path)
+    , _reload_signal(reload_signal)
+    , _reload(std::move(reload))
+{
+    SRV_ERROR("Not implemented");
+}
+
+config_watcher::~config_watcher()
+{
+}
+
+void config_watcher::watch_loop()
+{
+}
+#endif // !SERVER_LIB_PLATFORM_LINUX
+
+} // namespace server_lib
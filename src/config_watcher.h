@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace server_lib {
+
+/**
+ * \brief Calls reload in own thread if config file was rewritten
+ * (inotify) or if reload signal was received
+ *
+ * Signal handler only wakes up the thread (async-signal-safe).
+ */
+class config_watcher
+{
+public:
+    using reload_type = std::function<void()>;
+
+    config_watcher(const std::string& path, int reload_signal, reload_type&& reload);
+    ~config_watcher();
+
+private:
+    void watch_loop();
+
+private:
+    const std::string _path;
+    const int _reload_signal;
+    reload_type _reload;
+
+    int _inotify_fd = -1;
+    int _wake_fd = -1;
+    std::atomic_bool _stop { false };
+    std::thread _thread;
+};
+
+} // namespace server_lib
@@ -0,0 +1,583 @@
+#include "file_writer.h"
+#include "lz_block.h"
+#include "log_index.h"
+#include "logging_trace.h"
+#include "thread_affinity.h"
+#include "uring_writer.h"
+
+#include <logger/platform_config.h>
+#include <logger/asserts.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+namespace server_lib {
+
+namespace {
+    // Producers wait if writer thread is behind
+    const size_t max_pending_blocks = 8;
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    // Advisory lock shared by processes. Nothing if no lock file
+    class file_lock
+    {
+    public:
+        explicit file_lock(int fd)
+            : _fd(fd)
+        {
+            if (_fd < 0)
+                return;
+            while (flock(_fd, LOCK_EX) != 0 && errno == EINTR)
+                ;
+        }
+
+        ~file_lock()
+        {
+            if (_fd >= 0)
+                flock(_fd, LOCK_UN);
+        }
+
+        file_lock(const file_lock&) = delete;
+        file_lock& operator=(const file_lock&) = delete;
+
+    private:
+        const int _fd;
+    };
+#endif
+} // namespace
+
+file_writer::file_writer(const std::string& path, const logger::file_options& options)
+    : _path(path)
+    , _options(options)
+{
+    SRV_ASSERT(!_path.empty(), "File path is required");
+    SRV_ASSERT(_options.block_size > 0 && _options.block_size <= lz_frame::max_block_size, "Invalid block size");
+
+    // Shared file needs O_APPEND, io_uring writes at offsets
+    if (_options.use_io_uring && !_options.shared)
+    {
+        try
+        {
+            // Block is a bit bigger than block_size (by last row). Bigger ones are written synchronously
+            _uring.reset(new uring_writer(max_pending_blocks, 2 * _options.block_size + lz_frame::header_size, _options.sqpoll));
+        }
+        catch (std::exception& e)
+        {
+            SRV_TRACE_SIGNAL(e.what());
+        }
+    }
+
+    open_file();
+    _current.data.reserve(_options.block_size);
+    _thread = std::thread(&file_writer::write_loop, this);
+}
+
+file_writer::~file_writer()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        submit_current();
+        _stop = true;
+    }
+    _write_cond.notify_one();
+    _thread.join();
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    if (_fd >= 0)
+        close(_fd);
+    if (_index_fd >= 0)
+        close(_index_fd);
+    if (_lock_fd >= 0)
+        close(_lock_fd);
+#endif
+}
+
+void file_writer::write(const char* data, size_t size, int64_t time_us)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_current.data.empty())
+    {
+        _current.min_time_us = time_us;
+        _current.max_time_us = time_us;
+    }
+    else
+    {
+        _current.min_time_us = std::min(_current.min_time_us, time_us);
+        _current.max_time_us = std::max(_current.max_time_us, time_us);
+    }
+    _current.data.append(data, size);
+    if (_current.data.size() < _options.block_size)
+        return;
+
+    _written_cond.wait(lock, [this]() {
+        return _pending.size() < max_pending_blocks || _stop;
+    });
+    submit_current();
+    lock.unlock();
+    _write_cond.notify_one();
+}
+
+void file_writer::flush(bool sync)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    submit_current();
+    if (sync)
+    {
+        // Empty block to sync by writer thread (it owns file)
+        _pending.emplace_back();
+        _pending.back().sync = true;
+        ++_submitted;
+    }
+    const auto target = _submitted;
+    _write_cond.notify_one();
+    _written_cond.wait(lock, [this, target]() {
+        return _written >= target;
+    });
+}
+
+void file_writer::submit_current()
+{
+    if (_current.data.empty())
+        return;
+
+    _pending.emplace_back();
+    _pending.back().data.swap(_current.data);
+    _pending.back().min_time_us = _current.min_time_us;
+    _pending.back().max_time_us = _current.max_time_us;
+    if (!_free.empty())
+    {
+        _current.data.swap(_free.back());
+        _free.pop_back();
+    }
+    _current.data.clear();
+    _current.data.reserve(_options.block_size);
+    ++_submitted;
+}
+
+void file_writer::write_loop()
+{
+    set_this_thread_name("ll-file");
+    set_this_thread_affinity(_options.cpu_affinity);
+
+    std::vector<block> batch;
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;)
+    {
+        if (_pending.empty())
+        {
+            if (_uring && _uring->in_flight())
+            {
+                lock.unlock();
+                try
+                {
+                    _uring->reap(true);
+                }
+                catch (std::exception& e)
+                {
+                    SRV_TRACE_SIGNAL(e.what());
+                }
+                lock.lock();
+                update_written();
+                continue;
+            }
+            if (_stop)
+                break;
+            // Partial block is written by period to be seen by tail readers
+            if (!_write_cond.wait_for(lock, _options.flush_period, [this]() { return !_pending.empty() || _stop; }))
+                submit_current();
+            continue;
+        }
+
+        while (!_pending.empty())
+        {
+            batch.emplace_back(std::move(_pending.front()));
+            _pending.pop_front();
+        }
+        lock.unlock();
+
+        try
+        {
+            write_batch(batch);
+        }
+        catch (std::exception& e)
+        {
+            SRV_TRACE_SIGNAL(e.what());
+        }
+
+        lock.lock();
+        for (auto& current : batch)
+        {
+            current.data.clear();
+            if (current.data.capacity())
+                _free.emplace_back(std::move(current.data));
+        }
+        _processed += batch.size();
+        batch.clear();
+        update_written();
+    }
+}
+
+void file_writer::update_written()
+{
+    _written = _uring ? _uring->oldest_in_flight(_processed) : _processed;
+    _written_cond.notify_all();
+}
+
+void file_writer::write_batch(const std::vector<block>& batch)
+{
+    uint64_t sequence = _processed;
+    for (const auto& current : batch)
+    {
+        write_block(current, sequence++);
+    }
+    flush_io();
+    // Queued block could refer to frame, so frames are reused by the next batch
+    _frames_used = 0;
+}
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+void file_writer::write_block(const block& current, uint64_t sequence)
+{
+    if (current.data.empty())
+    {
+        if (current.sync)
+        {
+            flush_io();
+            if (_uring)
+                _uring->wait_all();
+            fdatasync(_fd);
+        }
+        return;
+    }
+
+    const char* data = current.data.data();
+    size_t size = current.data.size();
+    if (_options.compress)
+    {
+        if (_frames_used == _frames.size())
+            _frames.emplace_back();
+        auto& frame = _frames[_frames_used++];
+        frame.clear();
+        append_lz_frame(frame, data, size);
+        data = frame.data();
+        size = frame.size();
+    }
+
+    if (_options.shared)
+    {
+        // Other processes append and rotate too
+        if (rotated_by_other())
+            reopen_file();
+        struct stat st;
+        if (fstat(_fd, &st) == 0)
+            _file_size = static_cast<size_t>(st.st_size);
+    }
+
+    if (_options.rotation_size && _file_size && _file_size + size > _options.rotation_size)
+    {
+        // Rest of the batch is written to new file
+        flush_io();
+        if (_options.shared)
+            rotate_shared(size);
+        else
+            rotate();
+    }
+
+    log_index_entry entry;
+    entry.min_time_us = current.min_time_us;
+    entry.max_time_us = current.max_time_us;
+    entry.offset = _file_size;
+    entry.size = size;
+
+    queue_data(data, size, sequence);
+    _file_size += size;
+
+    if (_options.shared)
+    {
+        // Block is one write. Its offset is known after write only
+        flush_io();
+        const auto end = lseek(_fd, 0, SEEK_CUR);
+        if (end >= static_cast<off_t>(size))
+        {
+            _file_size = static_cast<size_t>(end);
+            entry.offset = _file_size - size;
+        }
+    }
+
+    if (_index_fd >= 0)
+        append_log_index_entry(_index_entries, entry);
+}
+
+void file_writer::queue_data(const char* data, size_t size, uint64_t sequence)
+{
+    if (!_uring)
+    {
+        iovec iov;
+        iov.iov_base = const_cast<char*>(data);
+        iov.iov_len = size;
+        _iov.push_back(iov);
+        return;
+    }
+
+    if (size > _uring->buffer_size())
+    {
+        pwrite_all(_fd, data, size, _file_size);
+        return;
+    }
+
+    const auto index = _uring->acquire();
+    memcpy(_uring->buffer(index), data, size);
+    _uring->write(_fd, index, size, _file_size, sequence);
+}
+
+void file_writer::flush_io()
+{
+    if (_uring)
+        _uring->submit();
+    else if (!_iov.empty())
+        write_iov(_fd, _iov.data(), _iov.size());
+    _iov.clear();
+
+    if (_index_fd >= 0 && !_index_entries.empty())
+        write_all(_index_fd, _index_entries.data(), _index_entries.size());
+    _index_entries.clear();
+}
+
+void file_writer::write_iov(int fd, iovec* iov, size_t count)
+{
+    while (count > 0)
+    {
+        auto ln = ::writev(fd, iov, static_cast<int>(std::min<size_t>(count, IOV_MAX)));
+        if (ln < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            SRV_ERROR("Can't write log file");
+        }
+        // Skip written buffers and continue from the torn one
+        auto written = static_cast<size_t>(ln);
+        while (count > 0 && written >= iov->iov_len)
+        {
+            written -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+void file_writer::pwrite_all(int fd, const char* data, size_t size, uint64_t offset)
+{
+    while (size > 0)
+    {
+        auto ln = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (ln < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            SRV_ERROR("Can't write log file");
+        }
+        data += ln;
+        size -= static_cast<size_t>(ln);
+        offset += static_cast<uint64_t>(ln);
+    }
+}
+
+void file_writer::write_all(int fd, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        auto ln = ::write(fd, data, size);
+        if (ln < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            SRV_ERROR("Can't write log file");
+        }
+        data += ln;
+        size -= static_cast<size_t>(ln);
+    }
+}
+
+void file_writer::open_file()
+{
+    if (_options.shared && _lock_fd < 0)
+    {
+        const auto lock_path = _path + ".lock";
+        _lock_fd = ::open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        SRV_ASSERT(_lock_fd >= 0, "Can't open log lock file");
+    }
+    // Other process can't rotate between opening file and index
+    file_lock lock(_lock_fd);
+
+    // io_uring writes at offsets that could complete in any order
+    const int append_flag = _uring ? 0 : O_APPEND;
+    _fd = ::open(_path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | append_flag, 0644);
+    SRV_ASSERT(_fd >= 0, "Can't open log file");
+
+    struct stat st;
+    _file_size = (fstat(_fd, &st) == 0) ? static_cast<size_t>(st.st_size) : 0;
+
+    if (!_options.write_index)
+        return;
+
+    const auto index_path = log_index_path(_path);
+    _index_fd = ::open(index_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    SRV_ASSERT(_index_fd >= 0, "Can't open log index file");
+    if (fstat(_index_fd, &st) == 0 && st.st_size == 0)
+    {
+        std::string header;
+        write_log_index_header(header);
+        write_all(_index_fd, header.data(), header.size());
+    }
+}
+
+void file_writer::rotate()
+{
+    close_files();
+    move_files();
+    open_file();
+}
+
+void file_writer::rotate_shared(size_t size)
+{
+    {
+        file_lock lock(_lock_fd);
+
+        // The first process rotates, others find file replaced
+        struct stat st;
+        if (!rotated_by_other() && fstat(_fd, &st) == 0 && static_cast<size_t>(st.st_size) + size > _options.rotation_size)
+        {
+            close_files();
+            move_files();
+        }
+    }
+
+    reopen_file();
+}
+
+bool file_writer::rotated_by_other() const
+{
+    struct stat path_st, fd_st;
+    if (::stat(_path.c_str(), &path_st) != 0 || fstat(_fd, &fd_st) != 0)
+        return true;
+    return path_st.st_dev != fd_st.st_dev || path_st.st_ino != fd_st.st_ino;
+}
+
+void file_writer::reopen_file()
+{
+    close_files();
+    open_file();
+}
+
+void file_writer::close_files()
+{
+    if (_uring)
+        _uring->wait_all();
+    if (_fd >= 0)
+    {
+        close(_fd);
+        _fd = -1;
+    }
+    if (_index_fd >= 0)
+    {
+        close(_index_fd);
+        _index_fd = -1;
+    }
+}
+
+void file_writer::move_files()
+{
+    // path.N-1 -> path.N, ..., path -> path.1 (with indexes)
+    auto move = [this](const std::string& from, const std::string& to) {
+        std::rename(from.c_str(), to.c_str());
+        if (_options.write_index)
+            std::rename(log_index_path(from).c_str(), log_index_path(to).c_str());
+    };
+    if (_options.max_files > 0)
+    {
+        for (size_t ci = _options.max_files; ci > 1; --ci)
+        {
+            move(_path + '.' + std::to_string(ci - 1), _path + '.' + std::to_string(ci));
+        }
+        move(_path, _path + ".1");
+    }
+    else
+    {
+        std::remove(_path.c_str());
+        if (_options.write_index)
+            std::remove(log_index_path(_path).c_str());
+    }
+}
+#else // SERVER_LIB_PLATFORM_LINUX
+void file_writer::write_block(const block&, uint64_t)
+{
+}
+
+void file_writer::queue_data(const char*, size_t, uint64_t)
+{
+}
+
+void file_writer::flush_io()
+{
+}
+
+void file_writer::write_iov(int, iovec*, size_t)
+{
+}
+
+void file_writer::write_all(int, const char*, size_t)
+{
+}
+
+void file_writer::pwrite_all(int, const char*, size_t, uint64_t)
+{
+}
+
+void file_writer::open_file()
+{
+    SRV_ERROR("Not implemented");
+}
+
+void file_writer::rotate()
+{
+}
+
+void file_writer::rotate_shared(size_t)
+{
+}
+
+bool file_writer::rotated_by_other() const
+{
+    return false;
+}
+
+void file_writer::reopen_file()
+{
+}
+
+void file_writer::close_files()
+{
+}
+
+void file_writer::move_files()
+{
+}
+#endif // !SERVER_LIB_PLATFORM_LINUX
+
+} // namespace server_lib
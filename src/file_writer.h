@@ -0,0 +1,123 @@
+#pragma once
+
+#include <logger/logger.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct iovec;
+
+namespace server_lib {
+
+class uring_writer;
+
+/**
+ * \brief Backend of file destination
+ *
+ * Producers append rendered rows to the current block. Full block
+ * (or partial one by flush period) is passed to the own writer thread
+ * that compresses it (optionally), appends to file and rotates file
+ * by size. So compression and file I/O are off the producer path.
+ * Rotation is made at block boundary only.
+ *
+ * Optional side index (path.idx) gets entry per written block.
+ *
+ * In shared mode several processes append to the same file.
+ * Block holds whole records and is appended by single write
+ * (O_APPEND), so records of processes are never torn. Size is taken
+ * from file itself and rotation is made under flock of path.lock
+ * by the first process that finds file too big. Others reopen
+ * path when they see it was replaced.
+ *
+ * Writer thread takes all pending blocks at once. They are written
+ * by single writev or, with io_uring, copied to registered buffers
+ * and submitted at explicit offsets without waiting for completion
+ * (completions recycle buffers). Flush waits for completions.
+ */
+class file_writer
+{
+public:
+    file_writer(const std::string& path, const logger::file_options& options);
+    ~file_writer();
+
+    // Time of record is for index (microseconds since epoch)
+    void write(const char* data, size_t size, int64_t time_us);
+
+    // Wait for data written before this call is in file.
+    // Sync to storage device if required
+    void flush(bool sync = false);
+
+    // False if io_uring wasn't requested or is unavailable
+    bool uses_io_uring() const
+    {
+        return static_cast<bool>(_uring);
+    }
+
+private:
+    struct block
+    {
+        std::string data;
+        int64_t min_time_us = 0;
+        int64_t max_time_us = 0;
+        // fdatasync after writing
+        bool sync = false;
+    };
+
+    void write_loop();
+    void update_written();
+    void write_batch(const std::vector<block>& batch);
+    void write_block(const block& current, uint64_t sequence);
+    void queue_data(const char* data, size_t size, uint64_t sequence);
+    // Writes queued data (submits to io_uring) and index entries
+    void flush_io();
+    void write_iov(int fd, iovec* iov, size_t count);
+    void write_all(int fd, const char* data, size_t size);
+    void pwrite_all(int fd, const char* data, size_t size, uint64_t offset);
+    void open_file();
+    void rotate();
+    // Shared mode
+    void rotate_shared(size_t size);
+    bool rotated_by_other() const;
+    void reopen_file();
+    void close_files();
+    void move_files();
+    void submit_current();
+
+private:
+    const std::string _path;
+    const logger::file_options _options;
+
+    std::mutex _mutex;
+    std::condition_variable _write_cond;
+    std::condition_variable _written_cond;
+    block _current;
+    std::deque<block> _pending;
+    std::vector<std::string> _free;
+    uint64_t _submitted = 0;
+    // Blocks before this one are in file
+    uint64_t _written = 0;
+    // Blocks taken by writer thread
+    uint64_t _processed = 0;
+    bool _stop = false;
+
+    // Used by writer thread only
+    int _fd = -1;
+    int _index_fd = -1;
+    int _lock_fd = -1;
+    size_t _file_size = 0;
+    std::unique_ptr<uring_writer> _uring;
+    // Queued for writev. Frames of batch live until its end
+    std::vector<iovec> _iov;
+    std::deque<std::string> _frames;
+    size_t _frames_used = 0;
+    std::string _index_entries;
+
+    std::thread _thread;
+};
+
+} // namespace server_lib
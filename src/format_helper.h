@@ -0,0 +1,158 @@
+#pragma once
+
+#include <logger/log_fields.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace server_lib {
+
+// Locale independent number formatting without streams
+
+namespace format_helper {
+
+    // Writes digits backward ending at 'end'. Returns start of digits
+    inline char* format_uint(uint64_t value, char* end)
+    {
+        static const char digit_pairs[] = "00010203040506070809"
+                                          "10111213141516171819"
+                                          "20212223242526272829"
+                                          "30313233343536373839"
+                                          "40414243444546474849"
+                                          "50515253545556575859"
+                                          "60616263646566676869"
+                                          "70717273747576777879"
+                                          "80818283848586878889"
+                                          "90919293949596979899";
+        char* p = end;
+        while (value >= 100)
+        {
+            const unsigned idx = static_cast<unsigned>(value % 100) * 2;
+            value /= 100;
+            *--p = digit_pairs[idx + 1];
+            *--p = digit_pairs[idx];
+        }
+        if (value >= 10)
+        {
+            const unsigned idx = static_cast<unsigned>(value) * 2;
+            *--p = digit_pairs[idx + 1];
+            *--p = digit_pairs[idx];
+        }
+        else
+        {
+            *--p = static_cast<char>('0' + value);
+        }
+        return p;
+    }
+
+    inline void append_uint(std::string& out, uint64_t value)
+    {
+        char buff[20];
+        char* end = buff + sizeof(buff);
+        char* start = format_uint(value, end);
+        out.append(start, end);
+    }
+
+    inline void append_int(std::string& out, int64_t value)
+    {
+        if (value < 0)
+        {
+            out.push_back('-');
+            append_uint(out, 0 - static_cast<uint64_t>(value));
+        }
+        else
+            append_uint(out, static_cast<uint64_t>(value));
+    }
+
+    // Fixed width with leading zeros
+    inline void append_uint_padded(std::string& out, uint64_t value, size_t width)
+    {
+        char buff[20];
+        char* end = buff + sizeof(buff);
+        char* start = format_uint(value, end);
+        for (size_t ln = static_cast<size_t>(end - start); ln < width; ++ln)
+            out.push_back('0');
+        out.append(start, end);
+    }
+
+    // Returns false for NaN and infinity
+    inline bool append_double(std::string& out, double value)
+    {
+        if (!std::isfinite(value))
+            return false;
+
+        // Integral values are common (counters, sizes)
+        if (value == std::floor(value) && std::fabs(value) < 1e15)
+        {
+            append_int(out, static_cast<int64_t>(value));
+            return true;
+        }
+
+        // The shortest of 15 and 17 digits that reads back the same.
+        // Both printf and strtod use the current locale
+        char buff[40];
+        int ln = snprintf(buff, sizeof(buff), "%.15g", value);
+        if (ln <= 0)
+            return true;
+        if (strtod(buff, nullptr) != value)
+        {
+            ln = snprintf(buff, sizeof(buff), "%.17g", value);
+            if (ln <= 0)
+                return true;
+        }
+
+        // Locale decimal point (could be ',' or multibyte) is replaced by '.'
+        const char* end = buff + ln;
+        const char* point = buff;
+        while (point != end && ((*point >= '0' && *point <= '9') || *point == '-'))
+            ++point;
+        out.append(buff, static_cast<size_t>(point - buff));
+        if (point != end && *point != 'e' && *point != 'E')
+        {
+            out.push_back('.');
+            while (point != end && !(*point >= '0' && *point <= '9'))
+                ++point;
+        }
+        out.append(point, static_cast<size_t>(end - point));
+        return true;
+    }
+
+    // Plain text as ' key=value' pairs
+    inline void append_text_fields(std::string& out, const std::vector<log_field>& fields)
+    {
+        for (const auto& field : fields)
+        {
+            out.push_back(' ');
+            out.append(field.key);
+            out.push_back('=');
+            switch (field.kind)
+            {
+            case log_field::type::integer:
+                append_int(out, field.value.i);
+                break;
+            case log_field::type::unsigned_integer:
+                append_uint(out, field.value.u);
+                break;
+            case log_field::type::floating:
+                if (!append_double(out, field.value.d))
+                    out.append("nan");
+                break;
+            case log_field::type::boolean:
+                out.append(field.value.b ? "true" : "false");
+                break;
+            case log_field::type::string:
+                out.append(field.text);
+                break;
+            default:;
+            }
+        }
+    }
+
+} // namespace format_helper
+} // namespace server_lib
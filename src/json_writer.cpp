@@ -0,0 +1,216 @@
+#include "json_writer.h"
+#include "format_helper.h"
+#include "text_escape.h"
+
+#include <chrono>
+#include <unordered_map>
+
+namespace server_lib {
+
+namespace {
+    using namespace format_helper;
+
+    void append_escaped_char(std::string& out, unsigned char ch)
+    {
+        static const char hex_digits[] = "0123456789abcdef";
+        switch (ch)
+        {
+        case '"':
+            out.append("\\\"");
+            break;
+        case '\\':
+            out.append("\\\\");
+            break;
+        case '\n':
+            out.append("\\n");
+            break;
+        case '\r':
+            out.append("\\r");
+            break;
+        case '\t':
+            out.append("\\t");
+            break;
+        default:
+            char buff[6] = { '\\', 'u', '0', '0', hex_digits[ch >> 4], hex_digits[ch & 0xF] };
+            out.append(buff, sizeof(buff));
+        }
+    }
+
+    // Rendered once per key literal (per rendering thread). Cache is
+    // found by pointer and checked by text, so key of reused buffer
+    // is rendered again
+    const std::string& escaped_key(const char* key)
+    {
+        struct cached_key
+        {
+            std::string text;
+            std::string rendered;
+        };
+        static const size_t max_cached_keys = 4096;
+        thread_local std::unordered_map<const char*, cached_key> s_keys;
+
+        auto it = s_keys.find(key);
+        if (it != s_keys.end() && it->second.text == key)
+            return it->second.rendered;
+
+        if (it == s_keys.end() && s_keys.size() >= max_cached_keys)
+            s_keys.clear();
+
+        auto& cached = s_keys[key];
+        cached.text = key;
+        cached.rendered.clear();
+        cached.rendered.push_back(',');
+        cached.rendered.push_back('"');
+        append_json_escaped(cached.rendered, key, cached.text.size());
+        cached.rendered.append("\":");
+        return cached.rendered;
+    }
+
+    const char* to_json_level(logger::level lv)
+    {
+        switch (lv)
+        {
+        case logger::level::trace:
+            return "\"trace\"";
+        case logger::level::debug:
+            return "\"debug\"";
+        case logger::level::info:
+            return "\"info\"";
+        case logger::level::warning:
+            return "\"warning\"";
+        case logger::level::error:
+            return "\"error\"";
+        case logger::level::fatal:
+            return "\"fatal\"";
+        default:;
+        }
+        return "\"\"";
+    }
+
+    void append_quoted(std::string& out, const char* text, size_t size)
+    {
+        out.push_back('"');
+        append_json_escaped(out, text, size);
+        out.push_back('"');
+    }
+
+    void append_quoted(std::string& out, const std::string& text)
+    {
+        append_quoted(out, text.data(), text.size());
+    }
+
+    void append_field_value(std::string& out, const log_field& field)
+    {
+        switch (field.kind)
+        {
+        case log_field::type::integer:
+            append_int(out, field.value.i);
+            break;
+        case log_field::type::unsigned_integer:
+            append_uint(out, field.value.u);
+            break;
+        case log_field::type::floating:
+            if (!append_double(out, field.value.d))
+                out.append("null");
+            break;
+        case log_field::type::boolean:
+            out.append(field.value.b ? "true" : "false");
+            break;
+        case log_field::type::string:
+            append_quoted(out, field.text);
+            break;
+        default:
+            out.append("null");
+        }
+    }
+
+    bool has_detail(int details_filter, logger::details detail)
+    {
+        return (~details_filter & static_cast<int>(detail)) != 0;
+    }
+} // namespace
+
+void append_json_escaped(std::string& out, const char* text, size_t size)
+{
+    // Clean spans are found by SIMD scan (see text_escape.h)
+    const char* end = text + size;
+    for (;;)
+    {
+        const char* special = find_json_special(text, end);
+        out.append(text, static_cast<size_t>(special - text));
+        if (special == end)
+            break;
+        append_escaped_char(out, static_cast<unsigned char>(*special));
+        text = special + 1;
+    }
+}
+
+void append_json_field(std::string& out, const log_field& field)
+{
+    out.append(escaped_key(field.key));
+    append_field_value(out, field);
+}
+
+void render_json_line(std::string& out, const logger::log_message& msg, int details_filter,
+                      const std::string& application_name)
+{
+    const auto& context = msg.context;
+
+    out.append("{\"id\":");
+    append_uint(out, context.id);
+
+    if (has_detail(details_filter, logger::details::without_app_name))
+    {
+        out.append(",\"app\":");
+        append_quoted(out, application_name);
+    }
+    if (has_detail(details_filter, logger::details::without_time))
+    {
+        out.append(",\"ts_us\":");
+        auto since_epoch = context.time().time_since_epoch();
+        append_int(out, std::chrono::duration_cast<std::chrono::microseconds>(since_epoch).count());
+    }
+    if (has_detail(details_filter, logger::details::without_level))
+    {
+        out.append(",\"level\":");
+        out.append(to_json_level(context.lv));
+    }
+    if (has_detail(details_filter, logger::details::without_thread_info))
+    {
+        out.append(",\"pid\":");
+        append_uint(out, static_cast<uint64_t>(context.pid));
+        out.append(",\"thread\":");
+        append_uint(out, std::get<0>(context.thread_info));
+        const auto& name = std::get<1>(context.thread_info);
+        if (!name.empty())
+        {
+            out.append(",\"thread_name\":");
+            append_quoted(out, name);
+        }
+    }
+    if (has_detail(details_filter, logger::details::without_source_code))
+    {
+        out.append(",\"file\":");
+        append_quoted(out, context.file);
+        out.append(",\"line\":");
+        append_int(out, context.line);
+        out.append(",\"method\":");
+        append_quoted(out, context.method);
+    }
+
+    out.append(",\"message\":");
+    append_quoted(out, msg.message.text_data(), msg.message.text_size());
+
+    // Pre-rendered thread context
+    if (context.mdc)
+        out.append(context.mdc->json());
+
+    for (const auto& field : msg.fields)
+    {
+        append_json_field(out, field);
+    }
+
+    out.append("}\n");
+}
+
+} // namespace server_lib
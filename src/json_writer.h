@@ -0,0 +1,19 @@
+#pragma once
+
+#include <logger/logger.h>
+
+#include <string>
+
+namespace server_lib {
+
+// Appends the record as single JSON object line (JSON Lines)
+void render_json_line(std::string& out, const logger::log_message& msg, int details_filter,
+                      const std::string& application_name);
+
+// Appends ,"key":value
+void append_json_field(std::string& out, const log_field& field);
+
+// Appends text escaped as JSON string content (without quotes)
+void append_json_escaped(std::string& out, const char* text, size_t size);
+
+} // namespace server_lib
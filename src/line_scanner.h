@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace server_lib {
+
+// Position of the first '\n' in [begin, end) or end.
+// Compares 16 bytes at a time if SSE2 is available
+inline const char* find_new_line(const char* begin, const char* end)
+{
+#if defined(__SSE2__)
+    const __m128i new_line = _mm_set1_epi8('\n');
+    while (end - begin >= 16)
+    {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, new_line));
+        if (mask)
+            return begin + __builtin_ctz(static_cast<unsigned>(mask));
+        begin += 16;
+    }
+#endif
+    auto p = static_cast<const char*>(memchr(begin, '\n', static_cast<size_t>(end - begin)));
+    return p ? p : end;
+}
+
+// Calls handler(line, size) for every line without '\n'
+template <typename Handler>
+void for_each_line(const char* data, size_t size, Handler&& handler)
+{
+    const char* end = data + size;
+    while (data < end)
+    {
+        const char* line_end = find_new_line(data, end);
+        handler(data, static_cast<size_t>(line_end - data));
+        data = line_end + 1;
+    }
+}
+
+} // namespace server_lib
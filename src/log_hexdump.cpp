@@ -0,0 +1,168 @@
+#include <logger/log_hexdump.h>
+#include <logger/asserts.h>
+
+#include "format_helper.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace server_lib {
+
+namespace {
+    const size_t max_width = 64;
+    // Offset, hex digits with gaps, ASCII column and new line
+    const size_t max_row_size = 1 + 10 + max_width * 3 + max_width / 8 + 2 + max_width + 1;
+    const size_t batch_size = 4096;
+
+    // Two hex digits of every byte
+    struct hex_table
+    {
+        hex_table()
+        {
+            static const char hex_digits[] = "0123456789abcdef";
+            for (int ch = 0; ch < 256; ++ch)
+            {
+                pairs[ch * 2] = hex_digits[ch >> 4];
+                pairs[ch * 2 + 1] = hex_digits[ch & 0xF];
+            }
+        }
+
+        char pairs[512];
+    };
+
+    const char* hex_pairs()
+    {
+        static const hex_table table;
+        return table.pairs;
+    }
+
+    char* put_hex(char* p, unsigned char ch, const char* pairs)
+    {
+        memcpy(p, pairs + ch * 2, 2);
+        return p + 2;
+    }
+
+    char* put_offset(char* p, size_t offset, const char* pairs)
+    {
+        const auto value = static_cast<uint32_t>(offset);
+        p = put_hex(p, static_cast<unsigned char>(value >> 24), pairs);
+        p = put_hex(p, static_cast<unsigned char>(value >> 16), pairs);
+        p = put_hex(p, static_cast<unsigned char>(value >> 8), pairs);
+        p = put_hex(p, static_cast<unsigned char>(value), pairs);
+        return p;
+    }
+
+    char* put_row(char* p, const unsigned char* data, size_t size, size_t offset,
+                  const hexdump_options& options, const char* pairs)
+    {
+        *p++ = '\n';
+        if (options.offsets)
+        {
+            p = put_offset(p, offset, pairs);
+            *p++ = ' ';
+            *p++ = ' ';
+        }
+        for (size_t ci = 0; ci < options.width; ++ci)
+        {
+            if (ci < size)
+            {
+                p = put_hex(p, data[ci], pairs);
+            }
+            else if (options.ascii)
+            {
+                // ASCII column is aligned
+                *p++ = ' ';
+                *p++ = ' ';
+            }
+            else
+            {
+                break;
+            }
+            *p++ = ' ';
+            // Gap between groups of 8 bytes
+            if (ci % 8 == 7 && ci + 1 < options.width && (ci + 1 < size || options.ascii))
+                *p++ = ' ';
+        }
+        if (options.ascii)
+        {
+            *p++ = ' ';
+            *p++ = '|';
+            for (size_t ci = 0; ci < size; ++ci)
+            {
+                const auto ch = data[ci];
+                *p++ = (ch >= 0x20 && ch < 0x7F) ? static_cast<char>(ch) : '.';
+            }
+            *p++ = '|';
+        }
+        else
+        {
+            // Trailing space of the last byte
+            --p;
+        }
+        return p;
+    }
+
+    void put_truncated(std::ostream& out, size_t rest, bool compact)
+    {
+        char buff[64];
+        char* end = buff + sizeof(buff);
+        char* p = end;
+        static const char suffix[] = " more bytes";
+        p -= sizeof(suffix) - 1;
+        memcpy(p, suffix, sizeof(suffix) - 1);
+        p = format_helper::format_uint(rest, p);
+        static const char prefix[] = "... ";
+        p -= sizeof(prefix) - 1;
+        memcpy(p, prefix, sizeof(prefix) - 1);
+        *--p = compact ? ' ' : '\n';
+        out.rdbuf()->sputn(p, end - p);
+    }
+} // namespace
+
+std::ostream& operator<<(std::ostream& out, const hexdump_part& part)
+{
+    const auto& options = part.options;
+    SRV_ASSERT(options.width > 0 && options.width <= max_width, "Invalid hexdump width");
+
+    std::ostream::sentry sentry(out);
+    if (!sentry || !out.rdbuf())
+        return out;
+
+    const char* pairs = hex_pairs();
+    const auto data = static_cast<const unsigned char*>(part.data);
+    const size_t size = (options.max_bytes && part.size > options.max_bytes) ? options.max_bytes : part.size;
+
+    char batch[batch_size];
+    char* p = batch;
+    auto flush_batch = [&]() {
+        out.rdbuf()->sputn(batch, p - batch);
+        p = batch;
+    };
+
+    if (options.compact)
+    {
+        for (size_t ci = 0; ci < size; ++ci)
+        {
+            if (p + 2 > batch + batch_size)
+                flush_batch();
+            p = put_hex(p, data[ci], pairs);
+        }
+    }
+    else
+    {
+        for (size_t offset = 0; offset < size; offset += options.width)
+        {
+            if (p + max_row_size > batch + batch_size)
+                flush_batch();
+            p = put_row(p, data + offset, std::min(options.width, size - offset), offset, options, pairs);
+        }
+    }
+    flush_batch();
+
+    if (size < part.size)
+        put_truncated(out, part.size - size, options.compact);
+    return out;
+}
+
+} // namespace server_lib
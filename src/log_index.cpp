@@ -0,0 +1,97 @@
+#include "log_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace server_lib {
+
+namespace {
+    template <typename T>
+    void append_raw(std::string& out, T value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    T read_raw(const char* p)
+    {
+        T value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    const size_t entry_size = sizeof(int64_t) * 2 + sizeof(uint64_t) * 2;
+} // namespace
+
+const uint32_t log_index::magic;
+const uint32_t log_index::version;
+const size_t log_index::header_size;
+
+std::string log_index_path(const std::string& log_path)
+{
+    return log_path + ".idx";
+}
+
+void write_log_index_header(std::string& out)
+{
+    append_raw(out, log_index::magic);
+    append_raw(out, log_index::version);
+    append_raw(out, uint64_t(0));
+}
+
+void append_log_index_entry(std::string& out, const log_index_entry& entry)
+{
+    append_raw(out, entry.min_time_us);
+    append_raw(out, entry.max_time_us);
+    append_raw(out, entry.offset);
+    append_raw(out, entry.size);
+}
+
+bool read_log_index(const char* data, size_t size, std::vector<log_index_entry>& entries)
+{
+    entries.clear();
+    if (size < log_index::header_size
+        || read_raw<uint32_t>(data) != log_index::magic
+        || read_raw<uint32_t>(data + 4) != log_index::version)
+        return false;
+
+    const size_t count = (size - log_index::header_size) / entry_size;
+    entries.reserve(count);
+    const char* p = data + log_index::header_size;
+    for (size_t ci = 0; ci < count; ++ci, p += entry_size)
+    {
+        log_index_entry entry;
+        entry.min_time_us = read_raw<int64_t>(p);
+        entry.max_time_us = read_raw<int64_t>(p + 8);
+        entry.offset = read_raw<uint64_t>(p + 16);
+        entry.size = read_raw<uint64_t>(p + 24);
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+void make_log_index_bounds(const std::vector<log_index_entry>& entries, log_index_bounds& bounds)
+{
+    const size_t count = entries.size();
+    auto& max_prefix = bounds.max_prefix;
+    auto& min_suffix = bounds.min_suffix;
+    max_prefix.resize(count);
+    min_suffix.resize(count);
+    for (size_t ci = 0; ci < count; ++ci)
+    {
+        max_prefix[ci] = ci ? std::max(max_prefix[ci - 1], entries[ci].max_time_us) : entries[ci].max_time_us;
+        const size_t cj = count - 1 - ci;
+        min_suffix[cj] = ci ? std::min(min_suffix[cj + 1], entries[cj].min_time_us) : entries[cj].min_time_us;
+    }
+}
+
+std::pair<size_t, size_t> find_log_blocks(const log_index_bounds& bounds, int64_t from_us, int64_t to_us)
+{
+    const auto& max_prefix = bounds.max_prefix;
+    const auto& min_suffix = bounds.min_suffix;
+    const size_t first = static_cast<size_t>(std::lower_bound(max_prefix.begin(), max_prefix.end(), from_us) - max_prefix.begin());
+    const size_t last = static_cast<size_t>(std::upper_bound(min_suffix.begin(), min_suffix.end(), to_us) - min_suffix.begin());
+    return std::make_pair(first, std::max(first, last));
+}
+
+} // namespace server_lib
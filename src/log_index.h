@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace server_lib {
+
+/**
+ * \brief Sparse side index of file destination
+ *
+ * File path.idx has entry per written block (raw or LZ frame)
+ * with range of record times (microseconds since epoch).
+ * Records of different threads could be written out of order,
+ * so ranges of neighbour blocks could overlap.
+ */
+struct log_index_entry
+{
+    int64_t min_time_us;
+    int64_t max_time_us;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct log_index
+{
+    static const uint32_t magic = 0x58494C4C; // LLIX
+    static const uint32_t version = 1;
+    static const size_t header_size = 16;
+};
+
+std::string log_index_path(const std::string& log_path);
+
+void write_log_index_header(std::string& out);
+void append_log_index_entry(std::string& out, const log_index_entry& entry);
+
+// False if there is no valid index. Torn entry at the end is ignored
+bool read_log_index(const char* data, size_t size, std::vector<log_index_entry>& entries);
+
+// Running max of ends and running min (from the tail) of beginnings
+// of entries. Both are monotonic, so blocks are found by binary search
+struct log_index_bounds
+{
+    std::vector<int64_t> max_prefix;
+    std::vector<int64_t> min_suffix;
+};
+
+// Once per read index
+void make_log_index_bounds(const std::vector<log_index_entry>& entries, log_index_bounds& bounds);
+
+// Entries [first, last) that could have records in [from_us, to_us]
+std::pair<size_t, size_t> find_log_blocks(const log_index_bounds& bounds, int64_t from_us, int64_t to_us);
+
+} // namespace server_lib
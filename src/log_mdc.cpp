@@ -0,0 +1,68 @@
+#include <logger/log_mdc.h>
+
+#include "format_helper.h"
+#include "json_writer.h"
+
+#include <vector>
+
+namespace server_lib {
+
+namespace {
+    thread_local log_context_ref s_this_thread_context;
+} // namespace
+
+log_context_ref::log_context_ref(const log_context_ref& other)
+    : _frame(other._frame)
+{
+    if (_frame)
+        _frame->_refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+log_context_ref::~log_context_ref()
+{
+    if (_frame && _frame->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete _frame;
+}
+
+log_context_frame::log_context_frame(log_context_ref parent, log_field&& field)
+    : _parent(std::move(parent))
+    , _field(std::move(field))
+{
+    // Stack fields are joined: "[a=1] " + b=2 -> "[a=1 b=2] "
+    if (_parent)
+    {
+        _text = _parent->text();
+        _text.resize(_text.size() - 2);
+        _json = _parent->json();
+    }
+    else
+    {
+        _text.push_back('[');
+    }
+
+    std::string rendered;
+    format_helper::append_text_fields(rendered, std::vector<log_field> { _field });
+    // Without leading space for the first field
+    _text.append(_parent ? rendered : rendered.substr(1));
+    _text.append("] ");
+
+    append_json_field(_json, _field);
+}
+
+context_guard::context_guard(log_field&& field)
+    : _previous(s_this_thread_context)
+{
+    s_this_thread_context = log_context_ref::adopt(new log_context_frame(_previous, std::move(field)));
+}
+
+context_guard::~context_guard()
+{
+    s_this_thread_context = std::move(_previous);
+}
+
+const log_context_ref& this_thread_context()
+{
+    return s_this_thread_context;
+}
+
+} // namespace server_lib
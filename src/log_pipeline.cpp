@@ -0,0 +1,48 @@
+#include <logger/log_pipeline.h>
+
+#include "file_writer.h"
+#include "json_writer.h"
+#include "text_writer.h"
+
+#include <chrono>
+
+namespace server_lib {
+
+render_text::render_text(const char* time_format, bool with_pid, bool sanitize)
+    : _time_format(time_format)
+    , _with_pid(with_pid)
+    , _sanitize(sanitize)
+{
+}
+
+bool render_text::operator()(pipeline_record& record) const
+{
+    select_cli_renderer(record.details_filter, _sanitize)(record.text, record.msg, record.msg.context.time(),
+                                               _time_format, logger::application_name(), _with_pid);
+    return true;
+}
+
+bool render_json::operator()(pipeline_record& record) const
+{
+    render_json_line(record.text, record.msg, record.details_filter, logger::application_name());
+    return true;
+}
+
+file_sink::file_sink(const std::string& path, const logger::file_options& options)
+    : _writer(std::make_shared<file_writer>(path, options))
+{
+}
+
+bool file_sink::operator()(pipeline_record& record)
+{
+    const auto time_us = std::chrono::duration_cast<std::chrono::microseconds>(record.msg.context.time().time_since_epoch()).count();
+    _writer->write(record.text.data(), record.text.size(), time_us);
+    return true;
+}
+
+void file_sink::flush()
+{
+    _writer->flush();
+}
+
+} // namespace server_lib
@@ -0,0 +1,102 @@
+#include <logger/log_scope.h>
+#include <logger/asserts.h>
+
+#include <vector>
+
+namespace server_lib {
+
+namespace {
+    // Innermost scope of thread
+    thread_local buffered_scope* s_current_scope = nullptr;
+} // namespace
+
+buffered_scope::buffered_scope(logger::level threshold, size_t capacity)
+    : _threshold(static_cast<int>(threshold))
+    , _capacity(capacity)
+    , _parent(s_current_scope)
+{
+    SRV_ASSERT(_capacity > 0, "Capacity is required");
+    s_current_scope = this;
+}
+
+buffered_scope::~buffered_scope()
+{
+    if (s_current_scope == this)
+    {
+        s_current_scope = _parent;
+        return;
+    }
+
+    // Not the innermost one (e.g. heap allocated scope)
+    for (auto scope = s_current_scope; scope; scope = scope->_parent)
+    {
+        if (scope->_parent == this)
+        {
+            scope->_parent = _parent;
+            break;
+        }
+    }
+}
+
+void buffered_scope::commit()
+{
+    _committed = true;
+    write_records();
+}
+
+void buffered_scope::discard()
+{
+    _records.clear();
+}
+
+void buffered_scope::write_records()
+{
+    auto& log = logger::instance();
+    while (!_records.empty())
+    {
+        log.write_accepted(_records.front());
+        _records.pop_front();
+    }
+}
+
+bool buffered_scope::capture(logger::log_message& msg)
+{
+    auto scope = s_current_scope;
+    if (!scope)
+        return false;
+
+    const int lv = static_cast<int>(msg.context.lv);
+    if (lv <= static_cast<int>(logger::level::error))
+    {
+        // Failed: the oldest records first
+        std::vector<buffered_scope*> scopes;
+        for (auto current = scope; current; current = current->_parent)
+        {
+            scopes.push_back(current);
+        }
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+        {
+            (*it)->commit();
+        }
+        return false;
+    }
+
+    if (lv <= scope->_threshold)
+        return false;
+
+    if (scope->_committed)
+    {
+        logger::instance().write_accepted(msg);
+        return true;
+    }
+
+    if (scope->_records.size() >= scope->_capacity)
+    {
+        scope->_records.pop_front();
+        ++scope->_dropped;
+    }
+    scope->_records.emplace_back(std::move(msg));
+    return true;
+}
+
+} // namespace server_lib
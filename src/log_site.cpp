@@ -0,0 +1,264 @@
+#include <logger/log_site.h>
+#include <logger/asserts.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <vector>
+
+namespace server_lib {
+
+namespace {
+    struct site_rule
+    {
+        std::string query;
+        std::string file;
+        std::string function;
+        int line = 0;
+        site_mode mode = site_mode::level;
+    };
+
+    // Rules and registration are rare, so they are serialized
+    std::mutex s_rules_mutex;
+    std::vector<site_rule> s_rules;
+
+    std::atomic<size_t> s_shard_counter(0);
+
+    // Glob with '*' and '?'
+    bool glob_match(const char* pattern, const char* text)
+    {
+        const char* star = nullptr;
+        const char* star_text = nullptr;
+        while (*text)
+        {
+            if (*pattern == '*')
+            {
+                star = pattern++;
+                star_text = text;
+            }
+            else if (*pattern == '?' || *pattern == *text)
+            {
+                ++pattern;
+                ++text;
+            }
+            else if (star)
+            {
+                pattern = star + 1;
+                text = ++star_text;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        while (*pattern == '*')
+            ++pattern;
+        return !*pattern;
+    }
+
+    bool matches(const site_rule& rule, const log_site& site)
+    {
+        if (rule.line && rule.line != site.line())
+            return false;
+        if (!rule.function.empty() && !glob_match(rule.function.c_str(), site.function()))
+            return false;
+        if (!rule.file.empty())
+        {
+            const char* base_name = strrchr(site.file(), '/');
+            base_name = base_name ? base_name + 1 : site.file();
+            if (!glob_match(rule.file.c_str(), site.file()) && !glob_match(rule.file.c_str(), base_name))
+                return false;
+        }
+        return true;
+    }
+
+    site_rule parse_rule(const std::string& query, site_mode mode)
+    {
+        site_rule rule;
+        rule.query = query;
+        rule.mode = mode;
+
+        std::istringstream input(query);
+        std::string key, value;
+        bool empty = true;
+        while (input >> key)
+        {
+            SRV_ASSERT(input >> value, "Invalid site query");
+            if (key == "file")
+            {
+                rule.file = value;
+            }
+            else if (key == "func")
+            {
+                rule.function = value;
+            }
+            else if (key == "line")
+            {
+                char* end;
+                rule.line = static_cast<int>(strtol(value.c_str(), &end, 10));
+                SRV_ASSERT(!*end && rule.line > 0, "Invalid site line");
+            }
+            else
+            {
+                SRV_ERROR("Invalid site query");
+            }
+            empty = false;
+        }
+        SRV_ASSERT(!empty, "Empty site query");
+        return rule;
+    }
+} // namespace
+
+std::atomic<log_site*> log_site::s_head(nullptr);
+const size_t log_site::shards_count;
+
+site_mode log_site::mode()
+{
+    // Acquire to see counters of registration
+    const auto value = _mode.load(std::memory_order_acquire);
+    if (!value)
+        return register_site();
+    return static_cast<site_mode>(value);
+}
+
+site_mode log_site::register_site()
+{
+    std::lock_guard<std::mutex> lock(s_rules_mutex);
+
+    // Concurrent first calls
+    const auto value = _mode.load(std::memory_order_relaxed);
+    if (value)
+        return static_cast<site_mode>(value);
+
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignof(counters_shard), sizeof(counters_shard) * shards_count) != 0)
+        throw std::bad_alloc();
+    _shards = static_cast<counters_shard*>(memory);
+    for (size_t ci = 0; ci < shards_count; ++ci)
+    {
+        new (_shards + ci) counters_shard;
+    }
+
+    auto mode = site_mode::level;
+    for (const auto& rule : s_rules)
+    {
+        if (matches(rule, *this))
+            mode = rule.mode;
+    }
+    _mode.store(static_cast<uint8_t>(mode), std::memory_order_release);
+
+    _next = s_head.load(std::memory_order_relaxed);
+    s_head.store(this, std::memory_order_release);
+    return mode;
+}
+
+void log_site::record_hit(bool filtered, uint64_t bytes, uint64_t ticks, bool sampled)
+{
+    thread_local size_t index = s_shard_counter.fetch_add(1, std::memory_order_relaxed) % shards_count;
+
+    auto& shard = _shards[index];
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+    if (filtered)
+        shard.filtered.fetch_add(1, std::memory_order_relaxed);
+    shard.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (sampled)
+    {
+        shard.ticks.fetch_add(ticks, std::memory_order_relaxed);
+        shard.samples.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+log_site::counters log_site::collect() const
+{
+    counters result;
+    for (size_t ci = 0; ci < shards_count; ++ci)
+    {
+        const auto& shard = _shards[ci];
+        result.hits += shard.hits.load(std::memory_order_relaxed);
+        result.filtered += shard.filtered.load(std::memory_order_relaxed);
+        result.bytes += shard.bytes.load(std::memory_order_relaxed);
+        result.ticks += shard.ticks.load(std::memory_order_relaxed);
+        result.samples += shard.samples.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+void log_site::reset_counters()
+{
+    for_each([](log_site& site) {
+        for (size_t ci = 0; ci < shards_count; ++ci)
+        {
+            auto& shard = site._shards[ci];
+            shard.hits.store(0, std::memory_order_relaxed);
+            shard.filtered.store(0, std::memory_order_relaxed);
+            shard.bytes.store(0, std::memory_order_relaxed);
+            shard.ticks.store(0, std::memory_order_relaxed);
+            shard.samples.store(0, std::memory_order_relaxed);
+        }
+    });
+}
+
+size_t log_site::set_mode(const std::string& query, site_mode mode)
+{
+    auto rule = parse_rule(query, mode);
+
+    std::lock_guard<std::mutex> lock(s_rules_mutex);
+
+    // Rule is moved to the end to win over earlier ones
+    for (auto it = s_rules.begin(); it != s_rules.end(); ++it)
+    {
+        if (it->query == query)
+        {
+            s_rules.erase(it);
+            break;
+        }
+    }
+    s_rules.push_back(rule);
+
+    size_t matched = 0;
+    for_each([&](log_site& site) {
+        if (matches(rule, site))
+        {
+            site._mode.store(static_cast<uint8_t>(mode), std::memory_order_relaxed);
+            ++matched;
+        }
+    });
+    return matched;
+}
+
+bool log_site::clear_mode(const std::string& query)
+{
+    std::lock_guard<std::mutex> lock(s_rules_mutex);
+
+    auto it = s_rules.begin();
+    while (it != s_rules.end() && it->query != query)
+        ++it;
+    if (it == s_rules.end())
+        return false;
+    s_rules.erase(it);
+
+    for_each([](log_site& site) {
+        auto mode = site_mode::level;
+        for (const auto& rule : s_rules)
+        {
+            if (matches(rule, site))
+                mode = rule.mode;
+        }
+        site._mode.store(static_cast<uint8_t>(mode), std::memory_order_relaxed);
+    });
+    return true;
+}
+
+void log_site::reset_modes()
+{
+    std::lock_guard<std::mutex> lock(s_rules_mutex);
+
+    s_rules.clear();
+    for_each([](log_site& site) {
+        site._mode.store(static_cast<uint8_t>(site_mode::level), std::memory_order_relaxed);
+    });
+}
+
+} // namespace server_lib
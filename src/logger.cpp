@@ -2,6 +2,9 @@
 #include <logger/platform_config.h>
 #include <logger/asserts.h>
 #include <logger/time_helper.h>
+#include <logger/log_scope.h>
+#include <logger/log_site.h>
+#include <logger/logging_helper.h>
 
 #if defined(SERVER_LIB_PLATFORM_LINUX)
 #include <pthread.h>
@@ -13,12 +16,23 @@
 #include <windows.h>
 #endif //! SERVER_LIB_PLATFORM_LINUX
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <chrono>
 #include <fstream>
+#include <cstdlib>
 
 #include "logging_trace.h"
+#include "async_writer.h"
+#include "tsc_clock.h"
+#include "format_helper.h"
+#include "json_writer.h"
+#include "logger_stats.h"
+#include "config_watcher.h"
+#include "text_writer.h"
+#include "shm_ring.h"
+#include "file_writer.h"
 
 namespace server_lib {
 namespace {
@@ -67,6 +81,22 @@ namespace {
 
     static auto s_main_thread_info = get_thread_info();
 
+    int s_process_id = 0;
+
+    // getpid is a system call, so pid is cached and refreshed after fork
+    int get_process_id()
+    {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        static const bool registered = []() {
+            s_process_id = static_cast<int>(getpid());
+            pthread_atfork(nullptr, nullptr, []() { s_process_id = static_cast<int>(getpid()); });
+            return true;
+        }();
+        (void)registered;
+#endif
+        return s_process_id;
+    }
+
     std::string get_application_name()
     {
         std::string name;
@@ -87,10 +117,125 @@ namespace {
     }
 
     static auto s_this_application_name = get_application_name();
+
+    // Bytes written by current destination (reported by built-in ones)
+    thread_local uint64_t s_destination_bytes = 0;
+
+    // Profiled hits of thread (for sampling)
+    thread_local uint32_t s_site_hits = 0;
+
+    // Config state read by thread (see logger::config_guard).
+    // Slots are never freed, slot of exited thread is reused
+    struct config_reader
+    {
+        std::atomic<const void*> state { nullptr };
+        std::atomic_bool used { true };
+        config_reader* next = nullptr;
+    };
+
+    std::atomic<config_reader*> s_config_readers(nullptr);
+
+    config_reader* acquire_config_reader()
+    {
+        for (auto reader = s_config_readers.load(std::memory_order_acquire); reader; reader = reader->next)
+        {
+            bool used = false;
+            if (!reader->used.load(std::memory_order_relaxed) && reader->used.compare_exchange_strong(used, true, std::memory_order_acquire))
+                return reader;
+        }
+
+        auto reader = new config_reader;
+        reader->next = s_config_readers.load(std::memory_order_relaxed);
+        while (!s_config_readers.compare_exchange_weak(reader->next, reader, std::memory_order_release, std::memory_order_relaxed))
+            ;
+        return reader;
+    }
+
+    struct this_thread_config_reader
+    {
+        config_reader* reader = nullptr;
+        // Nested guards
+        size_t depth = 0;
+
+        ~this_thread_config_reader()
+        {
+            if (reader)
+                reader->used.store(false, std::memory_order_release);
+            reader = nullptr;
+        }
+    };
+
+    thread_local this_thread_config_reader s_this_thread_config_reader;
+
+    // Upper bound (ns) of bucket where the given part of records are
+    uint64_t latency_percentile(const logger::stats_snapshot& snapshot, double part)
+    {
+        uint64_t total = 0;
+        for (auto count : snapshot.write_latency)
+            total += count;
+        if (!total)
+            return 0;
+
+        const auto threshold = static_cast<uint64_t>(static_cast<double>(total) * part);
+        uint64_t accumulated = 0;
+        for (size_t ci = 0; ci < snapshot.write_latency.size(); ++ci)
+        {
+            accumulated += snapshot.write_latency[ci];
+            if (accumulated >= threshold)
+                return uint64_t(2) << ci;
+        }
+        return uint64_t(2) << (snapshot.write_latency.size() - 1);
+    }
+
+    // Integer filter or level name (threshold)
+    bool parse_level_filter(const std::string& value, int& filter)
+    {
+        static const std::pair<const char*, const int*> names[] = {
+            { "trace", &logger::level_trace },
+            { "debug", &logger::level_debug },
+            { "info", &logger::level_info },
+            { "warning", &logger::level_warning },
+            { "error", &logger::level_error },
+        };
+        for (const auto& name : names)
+        {
+            if (value == name.first)
+            {
+                filter = *name.second;
+                return true;
+            }
+        }
+
+        char* end;
+        auto input_filter = strtol(value.c_str(), &end, 10);
+        if (value.empty() || *end)
+            return false;
+        filter = static_cast<int>(input_filter);
+        return true;
+    }
+
+    std::string trimmed(const std::string& text)
+    {
+        static const char* spaces = " \t\r\n";
+        auto start = text.find_first_not_of(spaces);
+        if (start == std::string::npos)
+            return {};
+        auto end = text.find_last_not_of(spaces);
+        return text.substr(start, end - start + 1);
+    }
+
+    void flush_at_exit()
+    {
+        if (logger::check_instance())
+            logger::instance().flush();
+    }
 } // namespace
 
 std::atomic_ulong logger::log_context::s_id_counter(0u);
 
+const size_t logger::stats_snapshot::levels_count;
+const size_t logger::stats_snapshot::latency_buckets;
+
 const char* logger::default_time_format = "%Y-%m-%dT%H:%M:%S";
 
 const int logger::level_trace = static_cast<int>(logger::level::fatal);
@@ -115,82 +260,65 @@ const int logger::details_message_only = details_message_with_level +
 
 logger::log_context::log_context()
     : id(s_id_counter++)
+    , timestamp(tsc_clock::instance().now())
+    , pid(get_process_id())
+    , mdc(this_thread_context())
+    , site(nullptr)
 {
     thread_info = get_thread_info();
     if (get_thread_id(thread_info) == get_thread_id(s_main_thread_info))
         set_thread_main(thread_info, true);
 }
 
-void logger::add_cli_destination()
+void logger::log_message::render_deferred()
 {
-    if (_added_cli_destination)
+    if (deferred.empty())
         return;
 
-    auto to_cli_level = [](level lv) {
-        switch (lv)
+    auto text = message.str();
+    std::ostringstream rendered;
+    size_t position = 0;
+    for (const auto& part : deferred)
+    {
+        const auto part_position = std::min(part.first, text.size());
+        rendered.write(text.data() + position, static_cast<std::streamsize>(part_position - position));
+        position = part_position;
+        try
         {
-        case logger::level::trace:
-            return "[trace] ";
-        case logger::level::debug:
-            return "[debug] ";
-        case logger::level::info:
-            return "[info] ";
-        case logger::level::warning:
-            return "[warning] ";
-        case logger::level::error:
-            return "[error!] ";
-        case logger::level::fatal:
-            return "[fatal!!!] ";
-        default:;
+            part.second->render(rendered);
         }
-        return "";
-    };
+        catch (std::exception& e)
+        {
+            SRV_TRACE_SIGNAL(e.what());
+        }
+    }
+    rendered.write(text.data() + position, static_cast<std::streamsize>(text.size() - position));
+    deferred.clear();
 
-    auto cli_write = [this, to_cli_level](const log_message& msg, int details_filter) {
-        using std::chrono::system_clock;
-        auto now = system_clock::now();
+    message.str(rendered.str());
+    message.seekp(0, std::ios_base::end);
+}
 
-        std::lock_guard<std::mutex> lock(_mutex_for_row);
+logger::clock_type::time_point logger::log_context::time() const
+{
+    return tsc_clock::instance().to_time_point(timestamp);
+}
 
-        if (~details_filter & static_cast<int>(logger::details::without_app_name))
-        {
-            std::cout << s_this_application_name << ": ";
-        }
+void logger::add_cli_destination()
+{
+    if (_added_cli_destination)
+        return;
 
-        if (~details_filter & static_cast<int>(logger::details::without_time))
-        {
-            std::cout << to_iso_string(system_clock::to_time_t(now), _time_format.c_str(), false);
-            if (~details_filter & static_cast<int>(logger::details::without_microseconds))
-            {
-                auto transformed = now.time_since_epoch().count() / 1000;
-                auto micro = transformed % 1000000;
-                std::cout << '.' << micro << ' ';
-            }
-        }
-        if (~details_filter & static_cast<int>(logger::details::without_level))
-        {
-            std::cout << std::setw(11) << to_cli_level(msg.context.lv);
-        }
-        if (~details_filter & static_cast<int>(logger::details::without_thread_info) && !get_thread_main(msg.context.thread_info))
-        {
-            std::cout << '[';
-            std::cout << get_thread_id(msg.context.thread_info);
-            const auto& name = get_thread_name(msg.context.thread_info);
-            if (!name.empty())
-            {
-                std::cout << '-';
-                std::cout << get_thread_name(msg.context.thread_info);
-            }
-            std::cout << ']';
-        }
+    auto cli_write = [this](const log_message& msg, int) {
+        thread_local std::string row;
+        row.clear();
 
-        std::cout << msg.message.str();
+        _cli_renderer.load(std::memory_order_acquire)(row, msg, msg.context.time(), _time_format, s_this_application_name, false);
+        s_destination_bytes += row.size();
 
-        if (~details_filter & static_cast<int>(logger::details::without_source_code))
-        {
-            std::cout << " (from " << msg.context.file << ':' << msg.context.line << ')';
-        }
-        std::cout << std::endl;
+        std::lock_guard<std::mutex> lock(_mutex_for_row);
+        std::cout.write(row.data(), static_cast<std::streamsize>(row.size()));
+        std::cout.flush();
     };
     add_destination(std::move(cli_write));
 
@@ -203,38 +331,10 @@ void logger::add_syslog_destination()
         return;
 
 #if defined(SERVER_LIB_PLATFORM_LINUX)
-    auto to_syslog_level = [](level lv) -> int {
-        switch (lv)
-        {
-        case logger::level::trace:
-            return LOG_DEBUG;
-        case logger::level::debug:
-            return LOG_DEBUG;
-        case logger::level::info:
-            return LOG_INFO;
-        case logger::level::warning:
-            return LOG_WARNING;
-        case logger::level::error:
-            return LOG_ERR;
-        case logger::level::fatal:
-            return LOG_CRIT;
-        default:;
-        }
-        return LOG_DEBUG;
-    };
-
-    auto syslog_write = [to_syslog_level](const log_message& msg, int details_filter) {
-        if (~details_filter & static_cast<int>(logger::details::without_source_code))
-        {
-            syslog(to_syslog_level(msg.context.lv), "%s (from %s:%d)",
-                   msg.message.str().c_str(),
-                   msg.context.file.c_str(), msg.context.line);
-        }
-        else
-        {
-            syslog(to_syslog_level(msg.context.lv), "%s",
-                   msg.message.str().c_str());
-        }
+    auto syslog_write = [](const log_message& msg, int details_filter) {
+        auto text = render_syslog_text(msg, details_filter);
+        s_destination_bytes += text.size();
+        syslog(to_syslog_level(msg.context.lv), "%s", text.c_str());
     };
     add_destination(std::move(syslog_write));
 #else // SERVER_LIB_PLATFORM_LINUX
@@ -244,7 +344,136 @@ void logger::add_syslog_destination()
     _added_syslog_destination = true;
 }
 
-logger::logger() { _logs_on = false; }
+void logger::add_json_destination()
+{
+    if (_added_json_destination)
+        return;
+
+    auto json_write = [this](const log_message& msg, int details_filter) {
+        thread_local std::string line;
+        line.clear();
+        render_json_line(line, msg, details_filter, s_this_application_name);
+
+        std::lock_guard<std::mutex> lock(_mutex_for_row);
+        std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+        s_destination_bytes += line.size();
+    };
+    add_destination(std::move(json_write));
+
+    _added_json_destination = true;
+}
+
+void logger::add_shm_destination(const std::string& name, size_t capacity)
+{
+    if (_added_shm_destination)
+        return;
+
+    std::shared_ptr<shm_ring_writer> writer = std::make_shared<shm_ring_writer>(name, capacity, s_this_application_name);
+    auto shm_write = [this, writer](const log_message& msg, int details_filter) {
+        thread_local std::string text;
+        text.clear();
+        if (msg.context.mdc)
+            text = msg.context.mdc->text();
+        text.append(msg.message.text_data(), msg.message.text_size());
+        format_helper::append_text_fields(text, msg.fields);
+
+        const auto& thread_name = get_thread_name(msg.context.thread_info);
+
+        shm_record record;
+        record.id = msg.context.id;
+        record.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(msg.context.time().time_since_epoch()).count();
+        record.thread_id = get_thread_id(msg.context.thread_info);
+        record.line = msg.context.line;
+        record.level = static_cast<uint8_t>(msg.context.lv);
+        record.thread_main = get_thread_main(msg.context.thread_info) ? 1 : 0;
+        record.details_filter = static_cast<uint8_t>(details_filter);
+        record.file = { msg.context.file.data(), static_cast<uint32_t>(msg.context.file.size()) };
+        record.method = { msg.context.method.data(), static_cast<uint32_t>(msg.context.method.size()) };
+        record.thread_name = { thread_name.data(), static_cast<uint32_t>(thread_name.size()) };
+        record.message = { text.data(), static_cast<uint32_t>(text.size()) };
+
+        if (writer->write(record))
+            s_destination_bytes += text.size();
+        else
+            _stats->record_drop();
+    };
+    add_destination(std::move(shm_write));
+
+    _added_shm_destination = true;
+}
+
+void logger::add_file_destination(const std::string& path, const file_options& options)
+{
+    if (_added_file_destination)
+        return;
+
+    _file_writer.reset(new file_writer(path, options));
+    auto file_write = [this, options](const log_message& msg, int) {
+        thread_local std::string row;
+        row.clear();
+
+        _cli_renderer.load(std::memory_order_acquire)(row, msg, msg.context.time(), _time_format, s_this_application_name, options.shared);
+        s_destination_bytes += row.size();
+
+        const auto time_us = std::chrono::duration_cast<std::chrono::microseconds>(msg.context.time().time_since_epoch()).count();
+        _file_writer->write(row.data(), row.size(), time_us);
+    };
+    add_destination(std::move(file_write));
+
+    _added_file_destination = true;
+}
+
+logger::file_options::file_options()
+    : rotation_size(0)
+    , max_files(5)
+    , compress(false)
+    , block_size(64 << 10)
+    , flush_period(200)
+    , write_index(false)
+    , shared(false)
+    , use_io_uring(false)
+    , sqpoll(false)
+{
+}
+
+logger::async_options::async_options()
+    : flushers(1)
+    , queue_capacity(8192)
+    , numa_affinity(false)
+    , thread_name_prefix("ll")
+    , reorder_window(0)
+    , drop_on_overflow(false)
+    , external_drain(false)
+{
+}
+
+logger::logger()
+    : _config(nullptr)
+    , _cli_renderer(select_cli_renderer(logger::details_without_app_name))
+    , _stats(new logger_stats())
+    , _stats_period_ticks(0)
+    , _next_stats_ticks(0)
+    , _site_profiling(false)
+    , _site_sample_period(0)
+{
+    _logs_on = false;
+    _sync_errors = false;
+    _sanitize_text = false;
+
+    std::unique_ptr<config_state> config(new config_state);
+    config->level_filter = logger::level_trace;
+    config->details_filter = logger::details_without_app_name;
+    _config = config.get();
+    _config_states.push_back(std::move(config));
+}
+
+logger::~logger()
+{
+    _config_watcher.reset();
+    // Stop flushers before appenders destroyed
+    _async.reset();
+    _file_writer.reset();
+}
 
 logger& logger::init_cli_log(const char* time_format)
 {
@@ -268,6 +497,63 @@ logger& logger::init_sys_log()
     return *this;
 }
 
+logger& logger::init_json_log()
+{
+    add_json_destination();
+
+    unlock();
+    return *this;
+}
+
+logger& logger::init_shm_log(const std::string& name, size_t capacity)
+{
+    add_shm_destination(name, capacity);
+
+    unlock();
+    return *this;
+}
+
+logger& logger::init_file_log(const std::string& path, const file_options& options)
+{
+    add_file_destination(path, options);
+
+    unlock();
+    return *this;
+}
+
+logger& logger::init_async_log(const async_options& options)
+{
+    if (_async)
+        return *this;
+
+    _async.reset(new async_writer(options, [this](log_message& msg) {
+        msg.render_deferred();
+        // Records are dispatched by state current for flusher
+        config_guard config(*this);
+        dispatch(msg, *config);
+    }));
+
+    static std::once_flag at_exit_registered;
+    std::call_once(at_exit_registered, []() {
+        std::atexit(flush_at_exit);
+    });
+
+    return *this;
+}
+
+logger& logger::set_sync_errors(bool on)
+{
+    _sync_errors = on;
+    return *this;
+}
+
+logger& logger::set_sanitize_text(bool on)
+{
+    _sanitize_text = on;
+    update_cli_renderer();
+    return *this;
+}
+
 logger& logger::set_level(int filter)
 {
     // clang-format off
@@ -279,7 +565,9 @@ logger& logger::set_level(int filter)
     // clang-format on
     SRV_ASSERT(filter >= 0 && filter <= max_filter);
 
-    _level_filter = filter;
+    update_config([filter](config_state& config) {
+        config.level_filter = filter;
+    });
     return *this;
 }
 
@@ -309,7 +597,9 @@ logger& logger::set_details(int filter)
     // clang-format on
     SRV_ASSERT(filter >= 0 && filter <= max_filter);
 
-    _details_filter = filter;
+    update_config([filter](config_state& config) {
+        config.details_filter = filter;
+    });
     return *this;
 }
 
@@ -327,16 +617,340 @@ logger& logger::set_details_from_environment(const char* var_name)
     return *this;
 }
 
+logger& logger::set_destination_level(size_t index, int filter)
+{
+    SRV_ASSERT(index < config_guard(*this)->destination_levels.size(), "Invalid destination");
+    SRV_ASSERT(filter >= 0 && filter <= logger::level_error + static_cast<int>(level::error));
+
+    update_config([index, filter](config_state& config) {
+        config.destination_levels[index] = filter;
+    });
+    return *this;
+}
+
+int logger::destination_level_filter(size_t index) const
+{
+    config_guard config(*this);
+    SRV_ASSERT(index < config->destination_levels.size(), "Invalid destination");
+
+    return config->destination_levels[index];
+}
+
+logger& logger::load_config(const std::string& path)
+{
+    std::ifstream input(path);
+    if (!input)
+        return *this;
+
+    // Called by watcher thread
+    std::lock_guard<std::mutex> lock(_load_config_mutex);
+
+    static const int max_level_filter = logger::level_error + static_cast<int>(level::error);
+    static const int max_details_filter = logger::details_message_only;
+    static const std::string destination_prefix = "destination.";
+    static const std::string destination_suffix = ".level";
+
+    int new_level = -1;
+    int new_details = -1;
+    std::vector<std::pair<size_t, int>> new_destination_levels;
+    std::vector<std::pair<std::string, site_mode>> new_site_rules;
+
+    for (std::string line; std::getline(input, line);)
+    {
+        line = trimmed(line.substr(0, line.find('#')));
+        auto pos = line.find('=');
+        if (pos == std::string::npos)
+            continue;
+
+        auto key = trimmed(line.substr(0, pos));
+        auto value = trimmed(line.substr(pos + 1));
+
+        int filter = 0;
+        if (key == "level")
+        {
+            if (parse_level_filter(value, filter) && filter >= 0 && filter <= max_level_filter)
+                new_level = filter;
+        }
+        else if (key == "details")
+        {
+            char* end;
+            filter = static_cast<int>(strtol(value.c_str(), &end, 10));
+            if (!value.empty() && !*end && filter >= 0 && filter <= max_details_filter)
+                new_details = filter;
+        }
+        else if (key.size() > destination_prefix.size() + destination_suffix.size()
+                 && !key.compare(0, destination_prefix.size(), destination_prefix)
+                 && !key.compare(key.size() - destination_suffix.size(), destination_suffix.size(), destination_suffix))
+        {
+            auto index_str = key.substr(destination_prefix.size(),
+                                        key.size() - destination_prefix.size() - destination_suffix.size());
+            char* end;
+            auto index = strtoul(index_str.c_str(), &end, 10);
+            if (!*end && index < config_guard(*this)->destination_levels.size()
+                && parse_level_filter(value, filter) && filter >= 0 && filter <= max_level_filter)
+                new_destination_levels.emplace_back(index, filter);
+        }
+        else if (key == "site.on")
+        {
+            new_site_rules.emplace_back(value, site_mode::on);
+        }
+        else if (key == "site.off")
+        {
+            new_site_rules.emplace_back(value, site_mode::off);
+        }
+        else if (key == "site.level")
+        {
+            new_site_rules.emplace_back(value, site_mode::level);
+        }
+    }
+
+    // Rules removed from file are dropped
+    std::vector<std::string> site_queries;
+    for (const auto& item : new_site_rules)
+    {
+        site_queries.push_back(item.first);
+    }
+    for (const auto& query : _config_site_queries)
+    {
+        if (std::find(site_queries.begin(), site_queries.end(), query) == site_queries.end())
+            log_site::clear_mode(query);
+    }
+    site_queries.clear();
+    for (const auto& item : new_site_rules)
+    {
+        try
+        {
+            log_site::set_mode(item.first, item.second);
+            site_queries.push_back(item.first);
+        }
+        catch (std::exception& e)
+        {
+            SRV_TRACE_SIGNAL(e.what());
+        }
+    }
+    _config_site_queries.swap(site_queries);
+
+    // Destination levels removed from file are reset
+    std::vector<size_t> destinations;
+    for (const auto& item : new_destination_levels)
+    {
+        destinations.push_back(item.first);
+    }
+    update_config([&](config_state& config) {
+        if (new_level >= 0)
+            config.level_filter = new_level;
+        if (new_details >= 0)
+            config.details_filter = new_details;
+        for (auto index : _config_destinations)
+        {
+            if (std::find(destinations.begin(), destinations.end(), index) == destinations.end())
+                config.destination_levels[index] = logger::level_trace;
+        }
+        for (const auto& item : new_destination_levels)
+        {
+            config.destination_levels[item.first] = item.second;
+        }
+    });
+    _config_destinations.swap(destinations);
+
+    return *this;
+}
+
+logger& logger::set_sites(const std::string& query, site_mode mode)
+{
+    log_site::set_mode(query, mode);
+    return *this;
+}
+
+logger& logger::reset_sites()
+{
+    log_site::reset_modes();
+    return *this;
+}
+
+logger& logger::set_site_profiling(bool on, uint32_t sample_period)
+{
+    _site_sample_period = sample_period;
+    _site_profiling = on;
+    return *this;
+}
+
+logger::site_profile logger::dump_site_profile(size_t top) const
+{
+    const auto& clock = tsc_clock::instance();
+
+    std::vector<site_profile::site_stats> sites;
+    log_site::for_each([&](const log_site& site) {
+        const auto counters = site.collect();
+        if (!counters.hits)
+            return;
+
+        site_profile::site_stats item;
+        item.file = trim_file_path(site.file());
+        item.line = site.line();
+        item.method = site.function();
+        item.lv = site.lv();
+        item.hits = counters.hits;
+        item.filtered = counters.filtered;
+        item.bytes = counters.bytes;
+        if (counters.samples)
+        {
+            // Mean of samples for all hits
+            const auto ticks = static_cast<double>(counters.ticks) / static_cast<double>(counters.samples) * static_cast<double>(counters.hits);
+            item.time = clock.to_duration(static_cast<uint64_t>(ticks));
+        }
+        sites.push_back(std::move(item));
+    });
+
+    site_profile profile;
+    auto top_by = [&](std::vector<site_profile::site_stats>& result,
+                      bool (*greater)(const site_profile::site_stats&, const site_profile::site_stats&)) {
+        result = sites;
+        const auto count = std::min(top, result.size());
+        std::partial_sort(result.begin(), result.begin() + count, result.end(), greater);
+        result.resize(count);
+    };
+    top_by(profile.by_hits, [](const site_profile::site_stats& a, const site_profile::site_stats& b) {
+        return a.hits > b.hits;
+    });
+    top_by(profile.by_bytes, [](const site_profile::site_stats& a, const site_profile::site_stats& b) {
+        return a.bytes > b.bytes;
+    });
+    top_by(profile.by_time, [](const site_profile::site_stats& a, const site_profile::site_stats& b) {
+        return a.time > b.time;
+    });
+    return profile;
+}
+
+logger& logger::watch_config(const std::string& path, int reload_signal)
+{
+    _config_watcher.reset();
+
+    _config_path = path;
+    if (!_config_path.empty())
+        load_config(_config_path);
+
+    _config_watcher.reset(new config_watcher(path, reload_signal, [this]() {
+        reload_config();
+    }));
+    return *this;
+}
+
+void logger::reload_config()
+{
+    if (!_config_path.empty())
+        load_config(_config_path);
+    else
+        update_config([](config_state&) {});
+}
+
+logger::config_guard::config_guard(const logger& log)
+{
+    auto& local = s_this_thread_config_reader;
+    if (!local.reader)
+        local.reader = acquire_config_reader();
+    auto& slot = local.reader->state;
+    if (local.depth++)
+    {
+        _state = static_cast<const config_state*>(slot.load(std::memory_order_relaxed));
+        return;
+    }
+
+    // State is pinned if it is still current after slot is set
+    // (both are seq_cst as updater's store and scan)
+    auto state = log._config.load(std::memory_order_acquire);
+    for (;;)
+    {
+        slot.store(state, std::memory_order_seq_cst);
+        const auto current = log._config.load(std::memory_order_seq_cst);
+        if (current == state)
+            break;
+        state = current;
+    }
+    _state = state;
+}
+
+logger::config_guard::~config_guard()
+{
+    auto& local = s_this_thread_config_reader;
+    if (!--local.depth)
+        local.reader->state.store(nullptr, std::memory_order_release);
+}
+
+void logger::update_config(const std::function<void(config_state&)>& change)
+{
+    {
+        std::lock_guard<std::mutex> lock(_config_mutex);
+
+        std::unique_ptr<config_state> config(new config_state(current_config()));
+        change(*config);
+        ++config->epoch;
+        _config.store(config.get(), std::memory_order_seq_cst);
+        _config_states.push_back(std::move(config));
+
+        // Replaced states that no reader pins are freed
+        std::vector<const void*> pinned;
+        for (auto reader = s_config_readers.load(std::memory_order_acquire); reader; reader = reader->next)
+        {
+            const auto state = reader->state.load(std::memory_order_seq_cst);
+            if (state)
+                pinned.push_back(state);
+        }
+        const auto current = _config_states.back().get();
+        _config_states.erase(std::remove_if(_config_states.begin(), _config_states.end(),
+                                            [current, &pinned](const std::unique_ptr<config_state>& state) {
+                                                return state.get() != current
+                                                    && std::find(pinned.begin(), pinned.end(), state.get()) == pinned.end();
+                                            }),
+                             _config_states.end());
+    }
+
+    update_cli_renderer();
+}
+
+void logger::update_cli_renderer()
+{
+    // Last updater stores renderer of final details
+    int details;
+    bool sanitize;
+    do
+    {
+        details = details_filter();
+        sanitize = _sanitize_text.load(std::memory_order_acquire);
+        _cli_renderer.store(select_cli_renderer(details, sanitize), std::memory_order_release);
+    } while (details != details_filter()
+             || sanitize != _sanitize_text.load(std::memory_order_acquire));
+}
+
 void logger::lock() { _logs_on = false; }
 
 void logger::unlock() { _logs_on = true; }
 
 logger& logger::add_destination(log_handler_type&& handler)
 {
-    _appenders.push_back(std::move(handler));
+    destination item;
+    item.write = [](void* state, const log_message& msg, int details_filter) {
+        (*static_cast<log_handler_type*>(state))(msg, details_filter);
+    };
+    item.state = std::make_shared<log_handler_type>(std::move(handler));
+    return add_appender(std::move(item));
+}
+
+logger& logger::add_appender(destination&& item)
+{
+    // Level is published before destination could be dispatched
+    update_config([](config_state& config) {
+        config.destination_levels.push_back(logger::level_trace);
+    });
+    _appenders.push_back(std::move(item));
     return *this;
 }
 
+const std::string& logger::application_name()
+{
+    return s_this_application_name;
+}
+
 void logger::write(log_message& msg)
 {
     if (!_logs_on.load())
@@ -344,14 +958,54 @@ void logger::write(log_message& msg)
 
     try
     {
+        auto site = msg.context.site;
+        auto mode = site_mode::level;
+        if (site)
+        {
+            // Site is registered at the first call
+            mode = site->mode();
+            if (mode == site_mode::off)
+            {
+                _stats->record_filtered(msg.context.lv);
+                skip(*site);
+                return;
+            }
+        }
+
+        // Taken before record could be moved
+        const bool profiled = site && _site_profiling.load(std::memory_order_relaxed);
+        const auto timestamp = msg.context.timestamp;
+        uint64_t bytes = 0;
+        bool sampled = false;
+        if (profiled)
+        {
+            const auto position = msg.message.tellp();
+            bytes = (position > 0) ? static_cast<uint64_t>(position) : 0;
+            const auto period = _site_sample_period.load(std::memory_order_relaxed);
+            sampled = period && !(++s_site_hits % period);
+        }
+
+        // The same state filters and dispatches record
+        config_guard config(*this);
+        bool filtered = false;
         auto _lv = static_cast<int>(msg.context.lv);
-        if (!_lv || ~_level_filter & _lv)
+        // Kept by request scope regardless of level filter
+        const bool captured = buffered_scope::capture(msg);
+        if (!captured)
         {
-            for (const auto& appender : _appenders)
+            if (!_lv || ~config->level_filter & _lv || mode == site_mode::on)
+            {
+                write_accepted(msg, *config);
+            }
+            else
             {
-                appender(msg, _details_filter);
+                filtered = true;
+                _stats->record_filtered(msg.context.lv);
             }
         }
+
+        if (profiled)
+            site->record_hit(filtered, bytes, sampled ? tsc_clock::instance().now() - timestamp : 0, sampled);
     }
     catch (std::exception& e)
     {
@@ -359,4 +1013,184 @@ void logger::write(log_message& msg)
     }
 }
 
+void logger::skip(log_site& site)
+{
+    if (_site_profiling.load(std::memory_order_relaxed))
+        site.record_hit(true, 0, 0, false);
+}
+
+void logger::write_accepted(log_message& msg)
+{
+    config_guard config(*this);
+    write_accepted(msg, *config);
+}
+
+void logger::write_accepted(log_message& msg, const config_state& config)
+{
+    _stats->record_accepted(msg.context.lv);
+
+    const auto _lv = static_cast<int>(msg.context.lv);
+    const auto timestamp = msg.context.timestamp;
+    const bool urgent = !_lv || (_lv == static_cast<int>(level::error) && _sync_errors.load(std::memory_order_relaxed));
+    if (urgent && (_async || _file_writer))
+    {
+        msg.render_deferred();
+        dispatch_urgent(msg, config);
+    }
+    else if (_async)
+    {
+        _async->push(msg);
+    }
+    else
+    {
+        msg.render_deferred();
+        dispatch(msg, config);
+    }
+
+    emit_stats_if_expired(timestamp);
+}
+
+void logger::flush()
+{
+    if (_async)
+        _async->flush();
+    flush_appenders();
+    if (_file_writer)
+        _file_writer->flush();
+}
+
+int logger::drain_fd() const
+{
+    return _async ? _async->drain_fd() : -1;
+}
+
+size_t logger::drain(size_t max_records, std::chrono::microseconds max_time)
+{
+    if (!_async)
+        return 0;
+    return _async->drain_external(max_records, max_time);
+}
+
+void logger::flush_appenders()
+{
+    for (const auto& appender : _appenders)
+    {
+        if (!appender.flush)
+            continue;
+
+        try
+        {
+            appender.flush(appender.state.get());
+        }
+        catch (std::exception& e)
+        {
+            SRV_TRACE_SIGNAL(e.what());
+        }
+    }
+}
+
+void logger::dispatch_urgent(const log_message& msg, const config_state& config)
+{
+    // Keep order with records of this thread
+    if (_async)
+        _async->flush_this_thread();
+
+    dispatch(msg, config);
+
+    flush_appenders();
+    if (_file_writer)
+        _file_writer->flush(true);
+    std::lock_guard<std::mutex> lock(_mutex_for_row);
+    std::cout.flush();
+}
+
+void logger::dispatch(const log_message& msg, const config_state& config)
+{
+    auto& clock = tsc_clock::instance();
+    const auto details_filter = config.details_filter;
+    const auto _lv = static_cast<int>(msg.context.lv);
+    for (size_t ci = 0; ci < _appenders.size(); ++ci)
+    {
+        if (_lv && (config.destination_levels[ci] & _lv))
+            continue;
+
+        s_destination_bytes = 0;
+        const auto start = clock.now();
+        try
+        {
+            const auto& appender = _appenders[ci];
+            appender.write(appender.state.get(), msg, details_filter);
+        }
+        catch (std::exception& e)
+        {
+            _stats->record_drop();
+            SRV_TRACE_SIGNAL(e.what());
+        }
+        _stats->record_destination(ci, s_destination_bytes, clock.now() - start);
+    }
+    _stats->record_latency(clock.now() - msg.context.timestamp);
+}
+
+logger::stats_snapshot logger::stats() const
+{
+    stats_snapshot snapshot;
+    _stats->collect(snapshot, _appenders.size());
+    if (_async)
+        _async->collect_stats(snapshot);
+    return snapshot;
+}
+
+logger& logger::set_stats_period(std::chrono::milliseconds period)
+{
+    auto& clock = tsc_clock::instance();
+    const uint64_t period_ticks = clock.to_ticks(period);
+    _next_stats_ticks = clock.now() + period_ticks;
+    _stats_period_ticks = period_ticks;
+    return *this;
+}
+
+void logger::emit_stats_if_expired(uint64_t timestamp)
+{
+    const auto period_ticks = _stats_period_ticks.load(std::memory_order_relaxed);
+    if (!period_ticks)
+        return;
+
+    auto next_ticks = _next_stats_ticks.load(std::memory_order_relaxed);
+    if (timestamp < next_ticks)
+        return;
+    if (!_next_stats_ticks.compare_exchange_strong(next_ticks, timestamp + period_ticks))
+        return;
+
+    const auto snapshot = stats();
+
+    uint64_t accepted = 0, filtered = 0, bytes = 0;
+    std::chrono::nanoseconds time(0);
+    for (size_t ci = 0; ci < stats_snapshot::levels_count; ++ci)
+    {
+        accepted += snapshot.accepted[ci];
+        filtered += snapshot.filtered[ci];
+    }
+    for (const auto& destination : snapshot.destinations)
+    {
+        bytes += destination.bytes;
+        time += destination.time;
+    }
+
+    log_message msg;
+    msg.context.lv = level::info;
+    msg.context.file = __FILE__;
+    msg.context.line = __LINE__;
+    msg.context.method = "logger stats";
+    msg.message << "logger stats";
+    msg.add_fields(kv("accepted", accepted),
+                   kv("filtered", filtered),
+                   kv("drops", snapshot.drops),
+                   kv("queue_high_water", snapshot.queue_high_water),
+                   kv("bytes", bytes),
+                   kv("destinations_time_us", std::chrono::duration_cast<std::chrono::microseconds>(time).count()),
+                   kv("latency_p50_ns", latency_percentile(snapshot, 0.5)),
+                   kv("latency_p99_ns", latency_percentile(snapshot, 0.99)));
+    write(msg);
+}
+
 } // namespace server_lib
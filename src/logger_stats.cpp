@@ -0,0 +1,108 @@
+#include "logger_stats.h"
+#include "tsc_clock.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace server_lib {
+
+namespace {
+    std::atomic<size_t> s_shard_counter(0);
+
+    void reset(std::atomic<uint64_t>& counter)
+    {
+        counter.store(0, std::memory_order_relaxed);
+    }
+} // namespace
+
+const size_t logger_stats::shards_count;
+const size_t logger_stats::max_destinations;
+
+logger_stats::logger_stats()
+{
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignof(shard), sizeof(shard) * shards_count) != 0)
+        throw std::bad_alloc();
+    _shards = static_cast<shard*>(memory);
+    for (size_t ci = 0; ci < shards_count; ++ci)
+    {
+        auto& current = *new (_shards + ci) shard;
+        std::for_each(current.accepted.begin(), current.accepted.end(), reset);
+        std::for_each(current.filtered.begin(), current.filtered.end(), reset);
+        std::for_each(current.latency.begin(), current.latency.end(), reset);
+    }
+}
+
+logger_stats::~logger_stats()
+{
+    for (size_t ci = 0; ci < shards_count; ++ci)
+    {
+        _shards[ci].~shard();
+    }
+    free(_shards);
+}
+
+logger_stats::shard& logger_stats::this_shard()
+{
+    thread_local size_t index = s_shard_counter.fetch_add(1, std::memory_order_relaxed) % shards_count;
+    return _shards[index];
+}
+
+void logger_stats::record_destination(size_t index, uint64_t bytes, uint64_t ticks)
+{
+    // Tail destinations share the last counters
+    auto& counters = this_shard().destinations[std::min(index, max_destinations - 1)];
+    counters.records.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    counters.ticks.fetch_add(ticks, std::memory_order_relaxed);
+}
+
+void logger_stats::record_latency(uint64_t ticks)
+{
+    uint64_t ns = static_cast<uint64_t>(tsc_clock::instance().to_duration(ticks).count());
+    size_t bucket = 0;
+    while (ns > 1 && bucket + 1 < snapshot_type::latency_buckets)
+    {
+        ns >>= 1;
+        ++bucket;
+    }
+    this_shard().latency[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void logger_stats::collect(snapshot_type& snapshot, size_t destinations_count) const
+{
+    const auto& clock = tsc_clock::instance();
+
+    snapshot.accepted.fill(0);
+    snapshot.filtered.fill(0);
+    snapshot.write_latency.fill(0);
+    snapshot.destinations.assign(std::min(destinations_count, max_destinations), {});
+
+    uint64_t drops = 0;
+    for (size_t cj = 0; cj < shards_count; ++cj)
+    {
+        const auto& shard = _shards[cj];
+        for (size_t ci = 0; ci < snapshot_type::levels_count; ++ci)
+        {
+            snapshot.accepted[ci] += shard.accepted[ci].load(std::memory_order_relaxed);
+            snapshot.filtered[ci] += shard.filtered[ci].load(std::memory_order_relaxed);
+        }
+        for (size_t ci = 0; ci < snapshot_type::latency_buckets; ++ci)
+        {
+            snapshot.write_latency[ci] += shard.latency[ci].load(std::memory_order_relaxed);
+        }
+        for (size_t ci = 0; ci < snapshot.destinations.size(); ++ci)
+        {
+            auto& destination = snapshot.destinations[ci];
+            const auto& counters = shard.destinations[ci];
+            destination.records += counters.records.load(std::memory_order_relaxed);
+            destination.bytes += counters.bytes.load(std::memory_order_relaxed);
+            destination.time += clock.to_duration(counters.ticks.load(std::memory_order_relaxed));
+        }
+        drops += shard.drops.load(std::memory_order_relaxed);
+    }
+    snapshot.drops += drops;
+}
+
+} // namespace server_lib
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <logger/logger.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace server_lib {
+
+/**
+ * \brief Logger self-metrics
+ *
+ * Counters are sharded by thread (relaxed increments
+ * to mostly private cache lines) and summed on collect.
+ */
+class logger_stats
+{
+public:
+    static const size_t shards_count = 16;
+    static const size_t max_destinations = 16;
+
+    using snapshot_type = logger::stats_snapshot;
+
+    logger_stats();
+    ~logger_stats();
+
+    logger_stats(const logger_stats&) = delete;
+    logger_stats& operator=(const logger_stats&) = delete;
+
+    void record_accepted(logger::level lv)
+    {
+        this_shard().accepted[logger::level_index(lv)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record_filtered(logger::level lv)
+    {
+        this_shard().filtered[logger::level_index(lv)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record_drop()
+    {
+        this_shard().drops.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record_destination(size_t index, uint64_t bytes, uint64_t ticks);
+
+    // From call site capture to written by all destinations
+    void record_latency(uint64_t ticks);
+
+    // Destinations, queue and drops of async mode are provided by caller
+    void collect(snapshot_type& snapshot, size_t destinations_count) const;
+
+private:
+    using counter_type = std::atomic<uint64_t>;
+
+    struct destination_counters
+    {
+        counter_type records { 0 };
+        counter_type bytes { 0 };
+        counter_type ticks { 0 };
+    };
+
+    struct alignas(64) shard
+    {
+        std::array<counter_type, snapshot_type::levels_count> accepted;
+        std::array<counter_type, snapshot_type::levels_count> filtered;
+        std::array<destination_counters, max_destinations> destinations;
+        std::array<counter_type, snapshot_type::latency_buckets> latency;
+        counter_type drops { 0 };
+    };
+
+    shard& this_shard();
+
+    // Cache line aligned by posix_memalign (new doesn't
+    // guarantee extended alignment before C++17)
+    shard* _shards;
+};
+
+} // namespace server_lib
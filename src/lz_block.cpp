@@ -0,0 +1,293 @@
+#include "lz_block.h"
+
+#include <logger/asserts.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace server_lib {
+
+namespace {
+    const size_t min_match = 4;
+    const size_t hash_log = 12;
+    // Format constraints to copy literals without end checks
+    const size_t last_literals = 5;
+    const size_t match_find_limit = 12;
+    const size_t max_offset = 65535;
+    const size_t run_mask = 15;
+
+    uint32_t read32(const uint8_t* p)
+    {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    void write32(char* p, uint32_t value)
+    {
+        // Little-endian in file
+        for (size_t ci = 0; ci < 4; ++ci)
+            p[ci] = static_cast<char>((value >> (8 * ci)) & 0xFF);
+    }
+
+    uint32_t read32_le(const char* p)
+    {
+        uint32_t value = 0;
+        for (size_t ci = 0; ci < 4; ++ci)
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(p[ci])) << (8 * ci);
+        return value;
+    }
+
+    uint32_t hash_sequence(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - hash_log);
+    }
+
+    void write_length(uint8_t*& op, size_t length)
+    {
+        while (length >= 255)
+        {
+            *op++ = 255;
+            length -= 255;
+        }
+        *op++ = static_cast<uint8_t>(length);
+    }
+
+    bool read_length(const uint8_t*& ip, const uint8_t* end, size_t& length)
+    {
+        uint8_t value = 0;
+        do
+        {
+            if (ip >= end)
+                return false;
+            value = *ip++;
+            length += value;
+        } while (value == 255);
+        return true;
+    }
+
+    void write_sequence(uint8_t*& op, const uint8_t* literals, size_t literal_length, size_t offset, size_t match_length)
+    {
+        uint8_t* token = op++;
+        *token = static_cast<uint8_t>(std::min(literal_length, run_mask) << 4);
+        if (literal_length >= run_mask)
+            write_length(op, literal_length - run_mask);
+        memcpy(op, literals, literal_length);
+        op += literal_length;
+
+        if (!offset)
+            return;
+
+        *op++ = static_cast<uint8_t>(offset & 0xFF);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+        *token |= static_cast<uint8_t>(std::min(match_length, run_mask));
+        if (match_length >= run_mask)
+            write_length(op, match_length - run_mask);
+    }
+
+    // FNV-1a
+    uint32_t checksum(const char* data, size_t size)
+    {
+        uint32_t hash = 2166136261u;
+        for (size_t ci = 0; ci < size; ++ci)
+        {
+            hash ^= static_cast<uint8_t>(data[ci]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+} // namespace
+
+const uint32_t lz_frame::magic;
+const size_t lz_frame::header_size;
+const size_t lz_frame::max_block_size;
+
+size_t lz_compress_bound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+size_t lz_compress(const char* source, size_t size, char* dest, size_t capacity)
+{
+    SRV_ASSERT(capacity >= lz_compress_bound(size), "Insufficient capacity");
+
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(source);
+    const uint8_t* end = src + size;
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    uint8_t* op = reinterpret_cast<uint8_t*>(dest);
+
+    if (size > match_find_limit)
+    {
+        uint32_t table[1 << hash_log];
+        memset(table, 0, sizeof(table));
+
+        const uint8_t* match_limit = end - match_find_limit;
+        const uint8_t* match_end_limit = end - last_literals;
+
+        ++ip;
+        while (ip < match_limit)
+        {
+            const uint32_t sequence = read32(ip);
+            const uint32_t h = hash_sequence(sequence);
+            const uint8_t* candidate = src + table[h];
+            table[h] = static_cast<uint32_t>(ip - src);
+
+            if (static_cast<size_t>(ip - candidate) > max_offset || read32(candidate) != sequence)
+            {
+                // Skip faster in incompressible data
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            while (ip > anchor && candidate > src && ip[-1] == candidate[-1])
+            {
+                --ip;
+                --candidate;
+            }
+
+            const uint8_t* match_end = ip + min_match;
+            const uint8_t* candidate_end = candidate + min_match;
+            while (match_end < match_end_limit && *match_end == *candidate_end)
+            {
+                ++match_end;
+                ++candidate_end;
+            }
+
+            write_sequence(op, anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - candidate),
+                           static_cast<size_t>(match_end - ip) - min_match);
+
+            ip = match_end;
+            anchor = ip;
+        }
+    }
+
+    write_sequence(op, anchor, static_cast<size_t>(end - anchor), 0, 0);
+    return static_cast<size_t>(reinterpret_cast<char*>(op) - dest);
+}
+
+bool lz_decompress(const char* source, size_t size, char* dest, size_t raw_size)
+{
+    const uint8_t* ip = reinterpret_cast<const uint8_t*>(source);
+    const uint8_t* end = ip + size;
+    uint8_t* const dst = reinterpret_cast<uint8_t*>(dest);
+    uint8_t* op = dst;
+    uint8_t* const dst_end = dst + raw_size;
+
+    while (ip < end)
+    {
+        const uint8_t token = *ip++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == run_mask && !read_length(ip, end, literal_length))
+            return false;
+        if (literal_length > static_cast<size_t>(end - ip) || literal_length > static_cast<size_t>(dst_end - op))
+            return false;
+        memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        // Last sequence has literals only
+        if (ip == end)
+            break;
+
+        if (end - ip < 2)
+            return false;
+        const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (!offset || offset > static_cast<size_t>(op - dst))
+            return false;
+
+        size_t match_length = token & run_mask;
+        if (match_length == run_mask && !read_length(ip, end, match_length))
+            return false;
+        match_length += min_match;
+        if (match_length > static_cast<size_t>(dst_end - op))
+            return false;
+
+        const uint8_t* match = op - offset;
+        if (offset >= match_length)
+        {
+            memcpy(op, match, match_length);
+            op += match_length;
+        }
+        else
+        {
+            // Overlapped copy repeats pattern
+            for (size_t ci = 0; ci < match_length; ++ci)
+                *op++ = *match++;
+        }
+    }
+    return op == dst_end;
+}
+
+void append_lz_frame(std::string& out, const char* data, size_t size)
+{
+    SRV_ASSERT(size <= lz_frame::max_block_size, "Too big block");
+
+    const size_t start = out.size();
+    out.resize(start + lz_frame::header_size + lz_compress_bound(size));
+
+    char* header = &out[start];
+    char* payload = header + lz_frame::header_size;
+    size_t stored_size = lz_compress(data, size, payload, lz_compress_bound(size));
+    if (stored_size >= size)
+    {
+        memcpy(payload, data, size);
+        stored_size = size;
+    }
+
+    write32(header, lz_frame::magic);
+    write32(header + 4, static_cast<uint32_t>(size));
+    write32(header + 8, static_cast<uint32_t>(stored_size));
+    write32(header + 12, checksum(payload, stored_size));
+    out.resize(start + lz_frame::header_size + stored_size);
+}
+
+size_t decode_lz_frames(const char* data, size_t size, std::string& out)
+{
+    size_t skipped = 0;
+    size_t position = 0;
+    while (position + lz_frame::header_size <= size)
+    {
+        const char* header = data + position;
+        const uint32_t raw_size = read32_le(header + 4);
+        const uint32_t stored_size = read32_le(header + 8);
+
+        bool valid = read32_le(header) == lz_frame::magic
+            && raw_size <= lz_frame::max_block_size
+            && stored_size <= raw_size
+            && stored_size <= size - position - lz_frame::header_size;
+        if (valid)
+        {
+            const char* payload = header + lz_frame::header_size;
+            valid = read32_le(header + 12) == checksum(payload, stored_size);
+            if (valid)
+            {
+                const size_t out_size = out.size();
+                if (stored_size == raw_size)
+                {
+                    out.append(payload, stored_size);
+                }
+                else
+                {
+                    out.resize(out_size + raw_size);
+                    valid = lz_decompress(payload, stored_size, &out[out_size], raw_size);
+                    if (!valid)
+                        out.resize(out_size);
+                }
+            }
+            if (valid)
+            {
+                position += lz_frame::header_size + stored_size;
+                continue;
+            }
+        }
+
+        ++position;
+        ++skipped;
+    }
+    return skipped + (size - position);
+}
+
+} // namespace server_lib
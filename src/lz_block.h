@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace server_lib {
+
+/**
+ * \brief LZ77 family block compression (LZ4-like sequences)
+ *
+ * Every block is compressed without history of previous ones,
+ * so blocks are decodable independently.
+ */
+size_t lz_compress_bound(size_t size);
+
+// Returns compressed size. Capacity must be at least lz_compress_bound(size)
+size_t lz_compress(const char* source, size_t size, char* dest, size_t capacity);
+
+// False if data is damaged. Decompressed size must be known exactly
+bool lz_decompress(const char* source, size_t size, char* dest, size_t raw_size);
+
+/**
+ * \brief Framed block of compressed file:
+ *
+ *   magic | raw size | stored size | checksum of stored data | stored data
+ *
+ * Data is stored raw if it is not compressible (stored size = raw size).
+ */
+struct lz_frame
+{
+    static const uint32_t magic = 0x425A4C4C; // LLZB
+    static const size_t header_size = 16;
+    static const size_t max_block_size = 16 << 20;
+};
+
+void append_lz_frame(std::string& out, const char* data, size_t size);
+
+// Decodes frames to out. Damaged or torn frames are skipped
+// by searching for the next valid header. Returns skipped bytes
+size_t decode_lz_frames(const char* data, size_t size, std::string& out);
+
+} // namespace server_lib
@@ -0,0 +1,192 @@
+#include "queued_record.h"
+
+#include <cstring>
+
+namespace server_lib {
+
+namespace {
+    using thread_info_type = logger::log_context::thread_info_type;
+
+    const size_t field_header_size = sizeof(const char*) + sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint32_t);
+    const size_t deferred_size = sizeof(uint64_t) + sizeof(log_deferred*);
+
+    size_t message_size(const logger::log_message& msg)
+    {
+        // Message is not read, so its size is put position
+        // (without copying of str())
+        auto position = const_cast<logger::log_message&>(msg).message.tellp();
+        return (position > 0) ? static_cast<size_t>(position) : 0;
+    }
+
+    template <typename T>
+    void put(char*& p, const T& value)
+    {
+        memcpy(p, &value, sizeof(value));
+        p += sizeof(value);
+    }
+
+    void put(char*& p, const char* data, size_t size)
+    {
+        memcpy(p, data, size);
+        p += size;
+    }
+
+    template <typename T>
+    T get(const char*& p)
+    {
+        T value;
+        memcpy(&value, p, sizeof(value));
+        p += sizeof(value);
+        return value;
+    }
+} // namespace
+
+size_t queued_record_size(const logger::log_message& msg)
+{
+    const auto& context = msg.context;
+    size_t size = sizeof(queued_record_header) + context.file.size() + context.method.size()
+        + std::get<1>(context.thread_info).size() + message_size(msg);
+    for (const auto& field : msg.fields)
+        size += field_header_size + field.text.size();
+    size += msg.deferred.size() * deferred_size;
+    return size;
+}
+
+void encode_queued_record(logger::log_message& msg, char* dest)
+{
+    const auto& context = msg.context;
+    const auto& thread_name = std::get<1>(context.thread_info);
+    auto header = reinterpret_cast<queued_record_header*>(dest);
+    header->id = context.id;
+    header->timestamp = context.timestamp;
+    header->thread_id = std::get<0>(context.thread_info);
+    header->line = context.line;
+    header->level = static_cast<uint8_t>(context.lv);
+    header->thread_main = std::get<2>(context.thread_info) ? 1 : 0;
+    header->fields_count = static_cast<uint16_t>(msg.fields.size());
+    header->file_size = static_cast<uint32_t>(context.file.size());
+    header->method_size = static_cast<uint32_t>(context.method.size());
+    header->thread_name_size = static_cast<uint32_t>(thread_name.size());
+    header->message_size = static_cast<uint32_t>(message_size(msg));
+    header->deferred_count = static_cast<uint32_t>(msg.deferred.size());
+    header->pid = context.pid;
+    header->mdc = msg.context.mdc.release();
+    header->spilled = nullptr;
+
+    char* p = dest + sizeof(queued_record_header);
+    put(p, context.file.data(), context.file.size());
+    put(p, context.method.data(), context.method.size());
+    put(p, thread_name.data(), thread_name.size());
+    msg.message.rdbuf()->sgetn(p, static_cast<std::streamsize>(header->message_size));
+    p += header->message_size;
+
+    for (size_t ci = 0; ci < header->fields_count; ++ci)
+    {
+        const auto& field = msg.fields[ci];
+        put(p, field.key);
+        put(p, static_cast<uint8_t>(field.kind));
+        put(p, field.value.u);
+        put(p, static_cast<uint32_t>(field.text.size()));
+        put(p, field.text.data(), field.text.size());
+    }
+    for (auto& part : msg.deferred)
+    {
+        put(p, static_cast<uint64_t>(part.first));
+        put(p, part.second.release());
+    }
+    msg.deferred.clear();
+}
+
+void encode_spilled_record(logger::log_message& msg, char* dest)
+{
+    auto header = reinterpret_cast<queued_record_header*>(dest);
+    memset(header, 0, sizeof(queued_record_header));
+    header->id = msg.context.id;
+    header->timestamp = msg.context.timestamp;
+    header->spilled = new logger::log_message(std::move(msg));
+}
+
+void decode_queued_record(const char* src, logger::log_message& msg)
+{
+    const auto& header = queued_record_of(src);
+    if (header.spilled)
+    {
+        msg = std::move(*header.spilled);
+        delete header.spilled;
+        return;
+    }
+
+    auto& context = msg.context;
+    context.id = static_cast<unsigned long>(header.id);
+    context.timestamp = header.timestamp;
+    context.line = header.line;
+    context.lv = static_cast<logger::level>(header.level);
+
+    const char* p = src + sizeof(queued_record_header);
+    context.file.assign(p, header.file_size);
+    p += header.file_size;
+    context.method.assign(p, header.method_size);
+    p += header.method_size;
+
+    // Strings are assigned to keep their capacity
+    std::get<0>(context.thread_info) = header.thread_id;
+    std::get<1>(context.thread_info).assign(p, header.thread_name_size);
+    std::get<2>(context.thread_info) = header.thread_main != 0;
+    p += header.thread_name_size;
+    context.pid = header.pid;
+    context.mdc = log_context_ref::adopt(header.mdc);
+
+    msg.message.clear();
+    msg.message.str(std::string());
+    msg.message.write(p, header.message_size);
+    p += header.message_size;
+
+    msg.fields.resize(header.fields_count);
+    for (auto& field : msg.fields)
+    {
+        field.key = get<const char*>(p);
+        field.kind = static_cast<log_field::type>(get<uint8_t>(p));
+        field.value.u = get<uint64_t>(p);
+        const auto text_size = get<uint32_t>(p);
+        field.text.assign(p, text_size);
+        p += text_size;
+    }
+
+    msg.deferred.clear();
+    for (size_t ci = 0; ci < header.deferred_count; ++ci)
+    {
+        const auto position = get<uint64_t>(p);
+        auto part = get<log_deferred*>(p);
+        msg.deferred.emplace_back(static_cast<size_t>(position), std::unique_ptr<log_deferred>(part));
+    }
+}
+
+void release_queued_record(const char* src)
+{
+    const auto& header = queued_record_of(src);
+    if (header.spilled)
+    {
+        delete header.spilled;
+        return;
+    }
+
+    log_context_ref::adopt(header.mdc);
+    if (!header.deferred_count)
+        return;
+
+    const char* p = src + sizeof(queued_record_header) + header.file_size + header.method_size
+        + header.thread_name_size + header.message_size;
+    for (size_t ci = 0; ci < header.fields_count; ++ci)
+    {
+        p += field_header_size - sizeof(uint32_t);
+        const auto text_size = get<uint32_t>(p);
+        p += text_size;
+    }
+    for (size_t ci = 0; ci < header.deferred_count; ++ci)
+    {
+        get<uint64_t>(p);
+        delete get<log_deferred*>(p);
+    }
+}
+
+} // namespace server_lib
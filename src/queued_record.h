@@ -0,0 +1,62 @@
+#pragma once
+
+#include <logger/logger.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace server_lib {
+
+/**
+ * \brief Layout of async record in producer ring
+ *
+ * Header is followed by payload: file, method, thread name,
+ * message, fields (key pointer, type, value, text) and
+ * lazy parts (position, owned pointer). Context frame reference
+ * is kept in header. Consumer decodes
+ * record into own reused log_message, so strings of queued
+ * record are neither allocated nor freed across threads.
+ * Record bigger than ring allows is spilled: message is moved
+ * to heap and header keeps only its order key and pointer.
+ */
+struct queued_record_header
+{
+    uint64_t id;
+    uint64_t timestamp;
+    uint64_t thread_id;
+    int32_t line;
+    uint8_t level;
+    uint8_t thread_main;
+    uint16_t fields_count;
+    uint32_t file_size;
+    uint32_t method_size;
+    uint32_t thread_name_size;
+    uint32_t message_size;
+    uint32_t deferred_count;
+    int32_t pid;
+    // Owned reference
+    const log_context_frame* mdc;
+    // Owned message of spilled record (other fields are unused)
+    logger::log_message* spilled;
+};
+
+size_t queued_record_size(const logger::log_message& msg);
+
+// Lazy parts and context reference are moved to record
+void encode_queued_record(logger::log_message& msg, char* dest);
+
+// Message is moved to heap. Record takes sizeof(queued_record_header)
+void encode_spilled_record(logger::log_message& msg, char* dest);
+
+// Lazy parts are moved to message
+void decode_queued_record(const char* src, logger::log_message& msg);
+
+// Frees lazy parts and context reference of not decoded record
+void release_queued_record(const char* src);
+
+inline const queued_record_header& queued_record_of(const char* src)
+{
+    return *reinterpret_cast<const queued_record_header*>(src);
+}
+
+} // namespace server_lib
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace server_lib {
+
+/**
+ * \brief Bounded lock-free ring of variable length records
+ * for exactly one producer and one consumer
+ *
+ * Record is a contiguous block of the ring (8 bytes aligned).
+ * The producer reserves and commits record, the consumer
+ * releases it. So there is no allocation per record.
+ *
+ * The consumer side may be handed over between threads
+ * if the handover itself is synchronized (acquire/release).
+ */
+class record_ring
+{
+    static const uint32_t padding_flag = 0x80000000u;
+    static const size_t header_size = 8;
+
+    static size_t round_up_pow2(size_t value)
+    {
+        size_t result = 4096;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    static size_t align8(size_t size)
+    {
+        return (size + 7) & ~size_t(7);
+    }
+
+public:
+    // Bytes capacity and limit of records count
+    record_ring(size_t capacity, size_t max_records)
+        : _capacity(round_up_pow2(capacity))
+        , _mask(_capacity - 1)
+        , _max_records(max_records ? max_records : 1)
+        // Zeroed to touch pages by constructing thread (first-touch NUMA placement)
+        , _buffer(new uint64_t[_capacity / sizeof(uint64_t)]())
+    {
+    }
+
+    record_ring(const record_ring&) = delete;
+    record_ring& operator=(const record_ring&) = delete;
+
+    // Bigger record never fits
+    size_t max_record_size() const
+    {
+        return _capacity / 2 - header_size;
+    }
+
+    // Producer side
+
+    // Block for record or nullptr if there is no space
+    char* reserve(size_t size)
+    {
+        const size_t total = align8(size + header_size);
+        const uint64_t tail = _tail.load(std::memory_order_relaxed);
+        const size_t offset = static_cast<size_t>(tail & _mask);
+        const size_t padding = (offset + total > _capacity) ? (_capacity - offset) : 0;
+        const uint64_t pushed = _pushed.load(std::memory_order_relaxed);
+        if (tail + padding + total - _cached_head > _capacity || pushed - _cached_popped >= _max_records)
+        {
+            // Records count is updated after head, so it is read first
+            _cached_popped = _popped.load(std::memory_order_acquire);
+            _cached_head = _head.load(std::memory_order_acquire);
+            if (tail + padding + total - _cached_head > _capacity || pushed - _cached_popped >= _max_records)
+                return nullptr;
+        }
+        if (padding)
+            write_size(offset, static_cast<uint32_t>(padding) | padding_flag);
+
+        const size_t position = static_cast<size_t>((tail + padding) & _mask);
+        write_size(position, static_cast<uint32_t>(total));
+        _reserved_tail = tail + padding + total;
+        return data() + position + header_size;
+    }
+
+    // Publish reserved record
+    void commit()
+    {
+        _tail.store(_reserved_tail, std::memory_order_release);
+        _pushed.store(_pushed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer side
+
+    // Oldest record or nullptr if ring is empty
+    char* front()
+    {
+        for (;;)
+        {
+            const uint64_t head = _head.load(std::memory_order_relaxed);
+            if (head == _cached_tail)
+            {
+                _cached_tail = _tail.load(std::memory_order_acquire);
+                if (head == _cached_tail)
+                    return nullptr;
+            }
+            const size_t position = static_cast<size_t>(head & _mask);
+            const uint32_t size = read_size(position);
+            if (size & padding_flag)
+            {
+                _head.store(head + (size & ~padding_flag), std::memory_order_release);
+                continue;
+            }
+            return data() + position + header_size;
+        }
+    }
+
+    // Release record returned by front()
+    void pop()
+    {
+        const uint64_t head = _head.load(std::memory_order_relaxed);
+        _head.store(head + read_size(static_cast<size_t>(head & _mask)), std::memory_order_release);
+        _popped.store(_popped.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Calls handler for up to limit records in FIFO order.
+    // Record is released right after handler returned
+    template <typename Handler>
+    size_t consume(Handler&& handler, size_t limit)
+    {
+        size_t handled = 0;
+        char* record = nullptr;
+        while (handled < limit && (record = front()) != nullptr)
+        {
+            handler(record);
+            pop();
+            ++handled;
+        }
+        return handled;
+    }
+
+    // Any side
+
+    bool empty() const
+    {
+        return head_position() == tail_position();
+    }
+
+    // Records count
+    size_t size() const
+    {
+        return static_cast<size_t>(tail_position() - head_position());
+    }
+
+    // Monotonic positions (count of pushed/consumed records)
+    uint64_t tail_position() const
+    {
+        return _pushed.load(std::memory_order_acquire);
+    }
+
+    uint64_t head_position() const
+    {
+        return _popped.load(std::memory_order_acquire);
+    }
+
+private:
+    char* data()
+    {
+        return reinterpret_cast<char*>(_buffer.get());
+    }
+
+    void write_size(size_t position, uint32_t size)
+    {
+        memcpy(data() + position, &size, sizeof(size));
+    }
+
+    uint32_t read_size(size_t position)
+    {
+        uint32_t size;
+        memcpy(&size, data() + position, sizeof(size));
+        return size;
+    }
+
+    static const size_t cache_line_size = 64;
+
+    const size_t _capacity;
+    const size_t _mask;
+    const size_t _max_records;
+    std::unique_ptr<uint64_t[]> _buffer;
+
+    char _pad0[cache_line_size];
+    std::atomic<uint64_t> _tail { 0 };
+    std::atomic<uint64_t> _pushed { 0 };
+    uint64_t _cached_head = 0;
+    uint64_t _cached_popped = 0;
+    uint64_t _reserved_tail = 0;
+
+    char _pad1[cache_line_size];
+    std::atomic<uint64_t> _head { 0 };
+    std::atomic<uint64_t> _popped { 0 };
+    uint64_t _cached_tail = 0;
+
+    char _pad2[cache_line_size];
+};
+
+} // namespace server_lib
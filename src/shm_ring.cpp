@@ -0,0 +1,417 @@
+#include "shm_ring.h"
+
+#include <logger/platform_config.h>
+#include <logger/asserts.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <new>
+
+namespace server_lib {
+
+namespace {
+    const uint32_t shm_magic = 0x4C4C5348; // LLSH
+    const uint32_t shm_version = 1;
+    const size_t header_area_size = 4096;
+    const size_t min_capacity = 4096;
+    const uint32_t padding_flag = 0x80000000u;
+
+    size_t align8(size_t size)
+    {
+        return (size + 7) & ~size_t(7);
+    }
+
+    size_t round_up_pow2(size_t value)
+    {
+        size_t result = min_capacity;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    uint16_t clamp16(uint32_t size)
+    {
+        return static_cast<uint16_t>((size > 0xFFFF) ? 0xFFFF : size);
+    }
+
+    std::string to_shm_name(const std::string& name)
+    {
+        if (!name.empty() && name[0] == '/')
+            return name;
+        return "/" + name;
+    }
+} // namespace
+
+struct shm_ring_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    char application_name[64];
+
+    alignas(64) std::atomic<uint64_t> reserve;
+    alignas(64) std::atomic<uint64_t> read;
+    alignas(64) std::atomic<uint32_t> wake_seq; // futex word
+    std::atomic<uint32_t> reader_waiting;
+    std::atomic<uint32_t> closed;
+    std::atomic<uint64_t> drops;
+};
+
+static_assert(sizeof(shm_ring_header) <= header_area_size, "Header doesn't fit");
+
+// Record in the ring. Strings follow it
+struct shm_record_header
+{
+    // Not zero if committed. Zero memory is released by reader
+    std::atomic<uint32_t> size;
+    uint32_t message_size;
+    uint64_t id;
+    int64_t time_ns;
+    uint64_t thread_id;
+    int32_t line;
+    uint8_t level;
+    uint8_t thread_main;
+    uint8_t details_filter;
+    uint8_t reserved;
+    uint16_t file_size;
+    uint16_t method_size;
+    uint16_t thread_name_size;
+    uint16_t reserved2;
+};
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+namespace {
+    void futex_wake(std::atomic<uint32_t>& word)
+    {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    }
+
+    void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::milliseconds timeout)
+    {
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+        ts.tv_nsec = static_cast<long>((timeout.count() % 1000) * 1000000);
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+    }
+} // namespace
+
+shm_ring_writer::shm_ring_writer(const std::string& name, size_t capacity, const std::string& application_name)
+    : _name(to_shm_name(name))
+{
+    const size_t ring_capacity = round_up_pow2(capacity);
+    _mapped_size = header_area_size + ring_capacity;
+
+    // Collector keeps previous object until it is drained
+    shm_unlink(_name.c_str());
+    int fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    SRV_ASSERT(fd >= 0, "Can't create shared memory");
+    if (ftruncate(fd, static_cast<off_t>(_mapped_size)) != 0)
+    {
+        close(fd);
+        shm_unlink(_name.c_str());
+        SRV_ERROR("Can't allocate shared memory");
+    }
+    void* p = mmap(nullptr, _mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+        shm_unlink(_name.c_str());
+        SRV_ERROR("Can't map shared memory");
+    }
+
+    _header = new (p) shm_ring_header();
+    _ring = static_cast<char*>(p) + header_area_size;
+
+    _header->version = shm_version;
+    _header->capacity = ring_capacity;
+    strncpy(_header->application_name, application_name.c_str(), sizeof(_header->application_name) - 1);
+    _header->reserve.store(0, std::memory_order_relaxed);
+    _header->read.store(0, std::memory_order_relaxed);
+    _header->wake_seq.store(0, std::memory_order_relaxed);
+    _header->reader_waiting.store(0, std::memory_order_relaxed);
+    _header->closed.store(0, std::memory_order_relaxed);
+    _header->drops.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _header->magic = shm_magic;
+}
+
+shm_ring_writer::~shm_ring_writer()
+{
+    _header->closed.store(1, std::memory_order_release);
+    _header->wake_seq.fetch_add(1);
+    futex_wake(_header->wake_seq);
+
+    shm_unlink(_name.c_str());
+    munmap(_header, _mapped_size);
+}
+
+bool shm_ring_writer::write(const shm_record& record)
+{
+    const uint64_t capacity = _header->capacity;
+    const uint64_t mask = capacity - 1;
+
+    // Long message is truncated to keep ring usable
+    const uint16_t file_size = clamp16(record.file.size);
+    const uint16_t method_size = clamp16(record.method.size);
+    const uint16_t thread_name_size = clamp16(record.thread_name.size);
+    const uint32_t strings_size = file_size + method_size + thread_name_size;
+    const uint64_t max_record_size = capacity / 4;
+    uint32_t message_size = record.message.size;
+    if (sizeof(shm_record_header) + strings_size + message_size > max_record_size)
+    {
+        if (sizeof(shm_record_header) + strings_size >= max_record_size)
+        {
+            _header->drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        message_size = static_cast<uint32_t>(max_record_size - sizeof(shm_record_header) - strings_size);
+    }
+    const uint64_t size = align8(sizeof(shm_record_header) + strings_size + message_size);
+
+    uint64_t position = _header->reserve.load(std::memory_order_relaxed);
+    uint64_t padding = 0;
+    for (;;)
+    {
+        const uint64_t offset = position & mask;
+        padding = (offset + size > capacity) ? (capacity - offset) : 0;
+        if (position + padding + size - _header->read.load(std::memory_order_acquire) > capacity)
+        {
+            _header->drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (_header->reserve.compare_exchange_weak(position, position + padding + size,
+                                                   std::memory_order_acq_rel, std::memory_order_relaxed))
+            break;
+    }
+
+    if (padding)
+    {
+        auto pad = reinterpret_cast<shm_record_header*>(_ring + (position & mask));
+        pad->size.store(static_cast<uint32_t>(padding) | padding_flag, std::memory_order_release);
+    }
+
+    char* p = _ring + ((position + padding) & mask);
+    auto header = reinterpret_cast<shm_record_header*>(p);
+    header->message_size = message_size;
+    header->id = record.id;
+    header->time_ns = record.time_ns;
+    header->thread_id = record.thread_id;
+    header->line = record.line;
+    header->level = record.level;
+    header->thread_main = record.thread_main;
+    header->details_filter = record.details_filter;
+    header->file_size = file_size;
+    header->method_size = method_size;
+    header->thread_name_size = thread_name_size;
+
+    p += sizeof(shm_record_header);
+    memcpy(p, record.file.data, header->file_size);
+    p += header->file_size;
+    memcpy(p, record.method.data, header->method_size);
+    p += header->method_size;
+    memcpy(p, record.thread_name.data, header->thread_name_size);
+    p += header->thread_name_size;
+    memcpy(p, record.message.data, message_size);
+
+    header->size.store(static_cast<uint32_t>(size), std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_header->reader_waiting.load(std::memory_order_relaxed))
+    {
+        _header->wake_seq.fetch_add(1, std::memory_order_release);
+        futex_wake(_header->wake_seq);
+    }
+    return true;
+}
+
+uint64_t shm_ring_writer::drops() const
+{
+    return _header->drops.load(std::memory_order_relaxed);
+}
+
+shm_ring_reader::shm_ring_reader(const std::string& name)
+{
+    const auto shm_name = to_shm_name(name);
+    int fd = shm_open(shm_name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    SRV_ASSERT(fd >= 0, "Can't open shared memory");
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < header_area_size + min_capacity)
+    {
+        close(fd);
+        SRV_ERROR("Invalid shared memory");
+    }
+    _mapped_size = static_cast<size_t>(st.st_size);
+
+    void* p = mmap(nullptr, _mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    SRV_ASSERT(p != MAP_FAILED, "Can't map shared memory");
+
+    _header = static_cast<shm_ring_header*>(p);
+    _ring = static_cast<char*>(p) + header_area_size;
+
+    if (_header->magic != shm_magic || _header->version != shm_version
+        || header_area_size + _header->capacity != _mapped_size)
+    {
+        munmap(p, _mapped_size);
+        SRV_ERROR("Unknown shared memory layout");
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+shm_ring_reader::~shm_ring_reader()
+{
+    munmap(_header, _mapped_size);
+}
+
+bool shm_ring_reader::next(shm_record& record)
+{
+    const uint64_t mask = _header->capacity - 1;
+
+    for (;;)
+    {
+        const uint64_t position = _header->read.load(std::memory_order_relaxed);
+        if (position == _header->reserve.load(std::memory_order_acquire))
+            return false;
+
+        char* p = _ring + (position & mask);
+        auto header = reinterpret_cast<shm_record_header*>(p);
+        const uint32_t size = header->size.load(std::memory_order_acquire);
+        // Reserved but not committed yet
+        if (!size)
+            return false;
+
+        if (size & padding_flag)
+        {
+            const uint32_t padding = size & ~padding_flag;
+            memset(p, 0, padding);
+            _header->read.store(position + padding, std::memory_order_release);
+            continue;
+        }
+
+        record.id = header->id;
+        record.time_ns = header->time_ns;
+        record.thread_id = header->thread_id;
+        record.line = header->line;
+        record.level = header->level;
+        record.thread_main = header->thread_main;
+        record.details_filter = header->details_filter;
+
+        p += sizeof(shm_record_header);
+        record.file = { p, header->file_size };
+        p += header->file_size;
+        record.method = { p, header->method_size };
+        p += header->method_size;
+        record.thread_name = { p, header->thread_name_size };
+        p += header->thread_name_size;
+        record.message = { p, header->message_size };
+
+        _current_size = size;
+        return true;
+    }
+}
+
+void shm_ring_reader::release()
+{
+    const uint64_t mask = _header->capacity - 1;
+    const uint64_t position = _header->read.load(std::memory_order_relaxed);
+
+    memset(_ring + (position & mask), 0, _current_size);
+    _header->read.store(position + _current_size, std::memory_order_release);
+    _current_size = 0;
+}
+
+void shm_ring_reader::wait(std::chrono::milliseconds timeout)
+{
+    const uint32_t seq = _header->wake_seq.load(std::memory_order_acquire);
+    _header->reader_waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    shm_record record;
+    if (!next(record) && !closed())
+        futex_wait(_header->wake_seq, seq, timeout);
+
+    _header->reader_waiting.store(0, std::memory_order_relaxed);
+}
+
+bool shm_ring_reader::closed() const
+{
+    return _header->closed.load(std::memory_order_acquire) != 0;
+}
+
+uint64_t shm_ring_reader::drops() const
+{
+    return _header->drops.load(std::memory_order_relaxed);
+}
+
+std::string shm_ring_reader::application_name() const
+{
+    return std::string(_header->application_name, strnlen(_header->application_name, sizeof(_header->application_name)));
+}
+#else // SERVER_LIB_PLATFORM_LINUX
+shm_ring_writer::shm_ring_writer(const std::string&, size_t, const std::string&)
+{
+    SRV_ERROR("Not implemented");
+}
+
+shm_ring_writer::~shm_ring_writer()
+{
+}
+
+bool shm_ring_writer::write(const shm_record&)
+{
+    return false;
+}
+
+uint64_t shm_ring_writer::drops() const
+{
+    return 0;
+}
+
+shm_ring_reader::shm_ring_reader(const std::string&)
+{
+    SRV_ERROR("Not implemented");
+}
+
+shm_ring_reader::~shm_ring_reader()
+{
+}
+
+bool shm_ring_reader::next(shm_record&)
+{
+    return false;
+}
+
+void shm_ring_reader::release()
+{
+}
+
+void shm_ring_reader::wait(std::chrono::milliseconds)
+{
+}
+
+bool shm_ring_reader::closed() const
+{
+    return true;
+}
+
+uint64_t shm_ring_reader::drops() const
+{
+    return 0;
+}
+
+std::string shm_ring_reader::application_name() const
+{
+    return {};
+}
+#endif // !SERVER_LIB_PLATFORM_LINUX
+
+} // namespace server_lib
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace server_lib {
+
+/**
+ * \brief Record of shared memory transport
+ *
+ * Strings point to writer data or into the ring (for reader).
+ * Reader's strings are valid while handler is called only.
+ */
+struct shm_record
+{
+    uint64_t id = 0;
+    // Wall-clock time since epoch
+    int64_t time_ns = 0;
+    uint64_t thread_id = 0;
+    int32_t line = 0;
+    uint8_t level = 0;
+    uint8_t thread_main = 0;
+    uint8_t details_filter = 0;
+
+    struct text
+    {
+        const char* data;
+        uint32_t size;
+    };
+
+    text file = { nullptr, 0 };
+    text method = { nullptr, 0 };
+    text thread_name = { nullptr, 0 };
+    text message = { nullptr, 0 };
+};
+
+struct shm_ring_header;
+
+/**
+ * \brief Variable length records ring in shared memory (shm_open)
+ *
+ * Many writers (threads of the application) reserve space by CAS
+ * and commit record by storing its size. The single reader
+ * (collector process) renders records and zeroes released space.
+ * Writer never waits for reader: if ring is full record is dropped
+ * and counted. Sleeping reader is woken up by futex.
+ */
+class shm_ring_writer
+{
+public:
+    // Creates new shared memory object (replacing previous one)
+    shm_ring_writer(const std::string& name, size_t capacity, const std::string& application_name);
+    ~shm_ring_writer();
+
+    shm_ring_writer(const shm_ring_writer&) = delete;
+    shm_ring_writer& operator=(const shm_ring_writer&) = delete;
+
+    // False if dropped
+    bool write(const shm_record& record);
+
+    uint64_t drops() const;
+
+private:
+    std::string _name;
+    size_t _mapped_size = 0;
+    shm_ring_header* _header = nullptr;
+    char* _ring = nullptr;
+};
+
+class shm_ring_reader
+{
+public:
+    // Attaches to existing shared memory object. Throws if it doesn't exist
+    explicit shm_ring_reader(const std::string& name);
+    ~shm_ring_reader();
+
+    shm_ring_reader(const shm_ring_reader&) = delete;
+    shm_ring_reader& operator=(const shm_ring_reader&) = delete;
+
+    // Calls handler for committed records. Waits up to timeout if there are not any
+    template <typename Handler>
+    size_t read(Handler&& handler, std::chrono::milliseconds timeout)
+    {
+        size_t handled = 0;
+        shm_record record;
+        while (next(record))
+        {
+            handler(record);
+            release();
+            ++handled;
+        }
+        if (!handled)
+            wait(timeout);
+        return handled;
+    }
+
+    // Writer has been destroyed
+    bool closed() const;
+    uint64_t drops() const;
+    std::string application_name() const;
+
+private:
+    bool next(shm_record& record);
+    void release();
+    void wait(std::chrono::milliseconds timeout);
+
+private:
+    size_t _mapped_size = 0;
+    shm_ring_header* _header = nullptr;
+    char* _ring = nullptr;
+    uint64_t _current_size = 0;
+};
+
+} // namespace server_lib
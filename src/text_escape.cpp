@@ -0,0 +1,265 @@
+#include "text_escape.h"
+
+#include <atomic>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define SERVER_LIB_ESCAPE_AVX2
+#endif
+
+namespace server_lib {
+
+namespace {
+    using finder_type = const char* (*)(const char*, const char*);
+
+    inline bool is_json_special(unsigned char ch)
+    {
+        return ch < 0x20 || ch == '"' || ch == '\\';
+    }
+
+    // Backslash starts escape sequence, so it is escaped too
+    inline bool is_control(unsigned char ch)
+    {
+        return (ch < 0x20 && ch != '\t') || ch == 0x7F || ch == '\\';
+    }
+
+    const char* find_json_special_scalar(const char* begin, const char* end)
+    {
+        for (; begin != end; ++begin)
+        {
+            if (is_json_special(static_cast<unsigned char>(*begin)))
+                return begin;
+        }
+        return end;
+    }
+
+    const char* find_control_scalar(const char* begin, const char* end)
+    {
+        for (; begin != end; ++begin)
+        {
+            if (is_control(static_cast<unsigned char>(*begin)))
+                return begin;
+        }
+        return end;
+    }
+
+#if defined(__SSE2__)
+    // Bytes <= 0x1F (unsigned): min(x, 0x1F) == x
+    inline __m128i less_than_space_sse2(__m128i chunk)
+    {
+        return _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(0x1F)), chunk);
+    }
+
+    const char* find_json_special_sse2(const char* begin, const char* end)
+    {
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        while (end - begin >= 16)
+        {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            const __m128i special = _mm_or_si128(less_than_space_sse2(chunk),
+                                                 _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+            const int mask = _mm_movemask_epi8(special);
+            if (mask)
+                return begin + __builtin_ctz(static_cast<unsigned>(mask));
+            begin += 16;
+        }
+        return find_json_special_scalar(begin, end);
+    }
+
+    const char* find_control_sse2(const char* begin, const char* end)
+    {
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i del = _mm_set1_epi8(0x7F);
+        const __m128i backslash = _mm_set1_epi8('\\');
+        while (end - begin >= 16)
+        {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            const __m128i control = _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi8(chunk, tab), less_than_space_sse2(chunk)),
+                                                 _mm_or_si128(_mm_cmpeq_epi8(chunk, del), _mm_cmpeq_epi8(chunk, backslash)));
+            const int mask = _mm_movemask_epi8(control);
+            if (mask)
+                return begin + __builtin_ctz(static_cast<unsigned>(mask));
+            begin += 16;
+        }
+        return find_control_scalar(begin, end);
+    }
+#endif // __SSE2__
+
+#if defined(SERVER_LIB_ESCAPE_AVX2)
+    __attribute__((target("avx2"))) inline __m256i less_than_space_avx2(__m256i chunk)
+    {
+        return _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, _mm256_set1_epi8(0x1F)), chunk);
+    }
+
+    __attribute__((target("avx2"))) const char* find_json_special_avx2(const char* begin, const char* end)
+    {
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        while (end - begin >= 32)
+        {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+            const __m256i special = _mm256_or_si256(less_than_space_avx2(chunk),
+                                                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)));
+            const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+            if (mask)
+                return begin + __builtin_ctz(mask);
+            begin += 32;
+        }
+        return find_json_special_scalar(begin, end);
+    }
+
+    __attribute__((target("avx2"))) const char* find_control_avx2(const char* begin, const char* end)
+    {
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i del = _mm256_set1_epi8(0x7F);
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        while (end - begin >= 32)
+        {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+            const __m256i control = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(chunk, tab), less_than_space_avx2(chunk)),
+                                                    _mm256_or_si256(_mm256_cmpeq_epi8(chunk, del), _mm256_cmpeq_epi8(chunk, backslash)));
+            const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(control));
+            if (mask)
+                return begin + __builtin_ctz(mask);
+            begin += 32;
+        }
+        return find_control_scalar(begin, end);
+    }
+#endif // SERVER_LIB_ESCAPE_AVX2
+
+    bool supported(escape_isa isa)
+    {
+        switch (isa)
+        {
+        case escape_isa::scalar:
+            return true;
+        case escape_isa::sse2:
+#if defined(__SSE2__)
+            return true;
+#else
+            return false;
+#endif
+        case escape_isa::avx2:
+#if defined(SERVER_LIB_ESCAPE_AVX2)
+            // Could be called by static initialization
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+#else
+            return false;
+#endif
+        default:;
+        }
+        return false;
+    }
+
+    struct finders
+    {
+        finder_type json;
+        finder_type control;
+    };
+
+    finders finders_of(escape_isa isa)
+    {
+        switch (isa)
+        {
+#if defined(SERVER_LIB_ESCAPE_AVX2)
+        case escape_isa::avx2:
+            return { find_json_special_avx2, find_control_avx2 };
+#endif
+#if defined(__SSE2__)
+        case escape_isa::sse2:
+            return { find_json_special_sse2, find_control_sse2 };
+#endif
+        default:;
+        }
+        return { find_json_special_scalar, find_control_scalar };
+    }
+
+    escape_isa best_isa()
+    {
+        if (supported(escape_isa::avx2))
+            return escape_isa::avx2;
+        if (supported(escape_isa::sse2))
+            return escape_isa::sse2;
+        return escape_isa::scalar;
+    }
+
+    // Constant initialized to be usable by static initialization
+    // of other units. The best ones are selected after
+    std::atomic<escape_isa> s_isa(escape_isa::scalar);
+    std::atomic<finder_type> s_find_json(find_json_special_scalar);
+    std::atomic<finder_type> s_find_control(find_control_scalar);
+
+    void append_sanitized_char(std::string& out, unsigned char ch)
+    {
+        static const char hex_digits[] = "0123456789abcdef";
+        switch (ch)
+        {
+        case '\n':
+            out.append("\\n");
+            break;
+        case '\r':
+            out.append("\\r");
+            break;
+        case '\\':
+            out.append("\\\\");
+            break;
+        default:
+            char buff[4] = { '\\', 'x', hex_digits[ch >> 4], hex_digits[ch & 0xF] };
+            out.append(buff, sizeof(buff));
+        }
+    }
+} // namespace
+
+bool set_escape_isa(escape_isa isa)
+{
+    if (!supported(isa))
+        return false;
+
+    const auto selected = finders_of(isa);
+    s_find_json.store(selected.json, std::memory_order_relaxed);
+    s_find_control.store(selected.control, std::memory_order_relaxed);
+    s_isa.store(isa, std::memory_order_relaxed);
+    return true;
+}
+
+namespace {
+    const bool s_best_isa_selected = set_escape_isa(best_isa());
+} // namespace
+
+escape_isa current_escape_isa()
+{
+    return s_isa.load(std::memory_order_relaxed);
+}
+
+const char* find_json_special(const char* begin, const char* end)
+{
+    return s_find_json.load(std::memory_order_relaxed)(begin, end);
+}
+
+const char* find_control(const char* begin, const char* end)
+{
+    return s_find_control.load(std::memory_order_relaxed)(begin, end);
+}
+
+void append_sanitized(std::string& out, const char* text, size_t size)
+{
+    const auto find = s_find_control.load(std::memory_order_relaxed);
+    const char* end = text + size;
+    for (;;)
+    {
+        const char* special = find(text, end);
+        out.append(text, static_cast<size_t>(special - text));
+        if (special == end)
+            break;
+        append_sanitized_char(out, static_cast<unsigned char>(*special));
+        text = special + 1;
+    }
+}
+
+} // namespace server_lib
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace server_lib {
+
+// Escaping of message payloads. Bytes are compared 32 (AVX2) or 16 (SSE2)
+// at a time to find ones requiring escape, clean spans are copied in bulk
+
+enum class escape_isa
+{
+    scalar,
+    sse2,
+    avx2,
+};
+
+// The best one supported by CPU is selected at start. Switching is for
+// benchmarks and tests. False if CPU (or build) doesn't support it
+bool set_escape_isa(escape_isa isa);
+escape_isa current_escape_isa();
+
+// First byte JSON string requires to escape (control, '"', '\\') or end
+const char* find_json_special(const char* begin, const char* end);
+
+// First control byte (except tab), DEL, '\\' or end
+const char* find_control(const char* begin, const char* end);
+
+// Appends text with control bytes escaped ("\n", "\r", "\xHH"), so text
+// stays single line for syslog or line based readers. Tab is kept.
+// Backslash is doubled, so escaped text is unambiguous
+void append_sanitized(std::string& out, const char* text, size_t size);
+
+} // namespace server_lib
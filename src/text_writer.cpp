@@ -0,0 +1,291 @@
+#include "text_writer.h"
+#include "format_helper.h"
+#include "text_escape.h"
+
+#include <logger/platform_config.h>
+#include <logger/time_helper.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <syslog.h>
+#endif
+
+namespace server_lib {
+
+const char* to_cli_level(logger::level lv)
+{
+    switch (lv)
+    {
+    case logger::level::trace:
+        return "[trace] ";
+    case logger::level::debug:
+        return "[debug] ";
+    case logger::level::info:
+        return "[info] ";
+    case logger::level::warning:
+        return "[warning] ";
+    case logger::level::error:
+        return "[error!] ";
+    case logger::level::fatal:
+        return "[fatal!!!] ";
+    default:;
+    }
+    return "";
+}
+
+namespace {
+    using details = logger::details;
+
+    // Level tags right aligned to 11 characters (as std::setw(11) did)
+    struct cli_level_tag
+    {
+        const char* data;
+        size_t size;
+    };
+
+    cli_level_tag to_cli_level_tag(logger::level lv)
+    {
+        switch (lv)
+        {
+        case logger::level::trace:
+            return { "   [trace] ", 11 };
+        case logger::level::debug:
+            return { "   [debug] ", 11 };
+        case logger::level::info:
+            return { "    [info] ", 11 };
+        case logger::level::warning:
+            return { " [warning] ", 11 };
+        case logger::level::error:
+            return { "  [error!] ", 11 };
+        case logger::level::fatal:
+            return { "[fatal!!!] ", 11 };
+        default:;
+        }
+        return { "           ", 11 };
+    }
+
+    void append_cli_time(std::string& row, logger::clock_type::time_point time, const std::string& time_format)
+    {
+        using std::chrono::system_clock;
+
+        char buff[64];
+        size_t size = 0;
+        if (!format_iso_time(system_clock::to_time_t(time), time_format.c_str(), buff, sizeof(buff), size, false))
+            row.append(buff, size);
+        else
+            row.append(to_iso_string(system_clock::to_time_t(time), time_format.c_str(), false));
+    }
+
+    void append_cli_thread_info(std::string& row, const logger::log_message& msg, bool with_pid)
+    {
+        const auto& thread_info = msg.context.thread_info;
+        const bool main = std::get<2>(thread_info);
+        if (!with_pid && main)
+            return;
+
+        row.push_back('[');
+        if (with_pid)
+        {
+            // Main thread of process is known by pid
+            format_helper::append_int(row, msg.context.pid);
+            if (!main)
+                row.push_back(':');
+        }
+        if (!main)
+        {
+            format_helper::append_uint(row, std::get<0>(thread_info));
+            const auto& name = std::get<1>(thread_info);
+            if (!name.empty())
+            {
+                row.push_back('-');
+                row.append(name);
+            }
+        }
+        row.push_back(']');
+    }
+
+    template <int Details>
+    bool has_detail(details detail)
+    {
+        return (~Details & static_cast<int>(detail)) != 0;
+    }
+
+    // Branches of details are resolved at compile time
+    template <int Details, bool Sanitize>
+    void render_cli_row_as(std::string& row,
+                           const logger::log_message& msg,
+                           logger::clock_type::time_point time,
+                           const std::string& time_format,
+                           const std::string& application_name,
+                           bool with_pid)
+    {
+        if (has_detail<Details>(details::without_app_name))
+        {
+            row.append(application_name);
+            row.append(": ");
+        }
+        if (has_detail<Details>(details::without_time))
+        {
+            append_cli_time(row, time, time_format);
+            if (has_detail<Details>(details::without_microseconds))
+            {
+                auto transformed = time.time_since_epoch().count() / 1000;
+                row.push_back('.');
+                format_helper::append_int(row, transformed % 1000000);
+                row.push_back(' ');
+            }
+        }
+        if (has_detail<Details>(details::without_level))
+        {
+            const auto tag = to_cli_level_tag(msg.context.lv);
+            row.append(tag.data, tag.size);
+        }
+        if (has_detail<Details>(details::without_thread_info))
+        {
+            append_cli_thread_info(row, msg, with_pid);
+        }
+
+        if (Sanitize)
+        {
+            if (msg.context.mdc)
+            {
+                const auto& context = msg.context.mdc->text();
+                append_sanitized(row, context.data(), context.size());
+            }
+            append_sanitized(row, msg.message.text_data(), msg.message.text_size());
+            if (!msg.fields.empty())
+            {
+                thread_local std::string fields;
+                fields.clear();
+                format_helper::append_text_fields(fields, msg.fields);
+                append_sanitized(row, fields.data(), fields.size());
+            }
+        }
+        else
+        {
+            if (msg.context.mdc)
+                row.append(msg.context.mdc->text());
+            row.append(msg.message.text_data(), msg.message.text_size());
+            format_helper::append_text_fields(row, msg.fields);
+        }
+
+        if (has_detail<Details>(details::without_source_code))
+        {
+            row.append(" (from ");
+            row.append(msg.context.file);
+            row.push_back(':');
+            format_helper::append_int(row, msg.context.line);
+            row.push_back(')');
+        }
+        row.push_back('\n');
+    }
+
+    const int cli_details_count = 64;
+    // Sanitized ones follow details combinations
+    const size_t cli_renderers_count = cli_details_count * 2;
+
+    template <int Index>
+    struct cli_renderers_filler
+    {
+        static void fill(cli_renderer* table)
+        {
+            table[Index] = &render_cli_row_as<Index % cli_details_count, (Index >= cli_details_count)>;
+            cli_renderers_filler<Index - 1>::fill(table);
+        }
+    };
+
+    template <>
+    struct cli_renderers_filler<-1>
+    {
+        static void fill(cli_renderer*)
+        {
+        }
+    };
+
+    struct cli_renderers_table
+    {
+        cli_renderers_table()
+        {
+            cli_renderers_filler<cli_renderers_count - 1>::fill(renderers);
+        }
+
+        cli_renderer renderers[cli_renderers_count];
+    };
+} // namespace
+
+cli_renderer select_cli_renderer(int details_filter, bool sanitize)
+{
+    static const cli_renderers_table table;
+    const auto index = static_cast<size_t>(details_filter) % cli_details_count + (sanitize ? cli_details_count : 0);
+    return table.renderers[index];
+}
+
+void render_cli_row(std::ostream& row,
+                    const logger::log_message& msg,
+                    logger::clock_type::time_point time,
+                    int details_filter,
+                    const std::string& time_format,
+                    const std::string& application_name,
+                    bool with_pid)
+{
+    thread_local std::string text;
+    text.clear();
+    select_cli_renderer(details_filter)(text, msg, time, time_format, application_name, with_pid);
+    row.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+int to_syslog_level(logger::level lv)
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    switch (lv)
+    {
+    case logger::level::trace:
+        return LOG_DEBUG;
+    case logger::level::debug:
+        return LOG_DEBUG;
+    case logger::level::info:
+        return LOG_INFO;
+    case logger::level::warning:
+        return LOG_WARNING;
+    case logger::level::error:
+        return LOG_ERR;
+    case logger::level::fatal:
+        return LOG_CRIT;
+    default:;
+    }
+    return LOG_DEBUG;
+#else
+    return 7;
+#endif
+}
+
+std::string render_syslog_text(const logger::log_message& msg, int details_filter)
+{
+
+    // Every record is single line of syslog
+    std::string text;
+    text.reserve(msg.message.text_size() + 64);
+    if (msg.context.mdc)
+    {
+        const auto& context = msg.context.mdc->text();
+        append_sanitized(text, context.data(), context.size());
+    }
+    append_sanitized(text, msg.message.text_data(), msg.message.text_size());
+    if (!msg.fields.empty())
+    {
+        thread_local std::string fields;
+        fields.clear();
+        format_helper::append_text_fields(fields, msg.fields);
+        append_sanitized(text, fields.data(), fields.size());
+    }
+    if (~details_filter & static_cast<int>(logger::details::without_source_code))
+    {
+        text += " (from ";
+        text += msg.context.file;
+        text.push_back(':');
+        format_helper::append_int(text, msg.context.line);
+        text.push_back(')');
+    }
+    return text;
+}
+
+} // namespace server_lib
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <logger/logger.h>
+
+#include <ostream>
+#include <string>
+
+namespace server_lib {
+
+// Layouts of text destinations (shared with out-of-process collector)
+
+const char* to_cli_level(logger::level lv);
+
+// Appends row of CLI destination with trailing new line
+using cli_renderer = void (*)(std::string& row,
+                              const logger::log_message& msg,
+                              logger::clock_type::time_point time,
+                              const std::string& time_format,
+                              const std::string& application_name,
+                              bool with_pid);
+
+// Renderer generated for details filter (one of 64 combinations)
+// without run-time checks of details. Sanitized one escapes control
+// bytes of payload (message, context, fields), see text_escape.h
+cli_renderer select_cli_renderer(int details_filter, bool sanitize = false);
+
+// Row of CLI destination with trailing new line.
+// Thread info is prefixed by pid if required ("[pid:thread-name]")
+void render_cli_row(std::ostream& row,
+                    const logger::log_message& msg,
+                    logger::clock_type::time_point time,
+                    int details_filter,
+                    const std::string& time_format,
+                    const std::string& application_name,
+                    bool with_pid = false);
+
+// Priority for syslog (LOG_DEBUG if unavailable)
+int to_syslog_level(logger::level lv);
+
+// Message with fields (control bytes escaped) and optional source code suffix
+std::string render_syslog_text(const logger::log_message& msg, int details_filter);
+
+} // namespace server_lib
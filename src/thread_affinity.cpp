@@ -0,0 +1,131 @@
+#include "thread_affinity.h"
+
+#include <logger/platform_config.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+namespace server_lib {
+
+numa_topology::numa_topology()
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    // Node numbers could be sparse ("0,2-3")
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string online_list;
+    std::getline(online, online_list);
+    for (auto node : parse_cpu_list(online_list))
+    {
+        std::ifstream input("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        std::getline(input, list);
+        auto cpus = parse_cpu_list(list);
+        // Memory only node
+        if (!cpus.empty())
+            _nodes.push_back(std::move(cpus));
+    }
+#endif
+    if (_nodes.empty())
+    {
+        std::vector<int> cpus;
+        for (unsigned ci = 0; ci < std::max(1u, std::thread::hardware_concurrency()); ++ci)
+        {
+            cpus.push_back(static_cast<int>(ci));
+        }
+        _nodes.push_back(std::move(cpus));
+    }
+}
+
+const numa_topology& numa_topology::instance()
+{
+    static numa_topology topology;
+    return topology;
+}
+
+size_t numa_topology::node_of_cpu(int cpu) const
+{
+    for (size_t ci = 0; ci < _nodes.size(); ++ci)
+    {
+        for (auto node_cpu : _nodes[ci])
+        {
+            if (node_cpu == cpu)
+                return ci;
+        }
+    }
+    return 0;
+}
+
+size_t numa_topology::current_node() const
+{
+    if (_nodes.size() < 2)
+        return 0;
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    return node_of_cpu(sched_getcpu());
+#else
+    return 0;
+#endif
+}
+
+std::vector<int> parse_cpu_list(const std::string& list)
+{
+    std::vector<int> cpus;
+    const char* p = list.c_str();
+    while (*p)
+    {
+        char* end = nullptr;
+        const long first = std::strtol(p, &end, 10);
+        if (end == p)
+            break;
+        long last = first;
+        p = end;
+        if (*p == '-')
+        {
+            last = std::strtol(p + 1, &end, 10);
+            if (end == p + 1)
+                break;
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+        if (*p != ',')
+            break;
+        ++p;
+    }
+    return cpus;
+}
+
+void set_this_thread_affinity(const std::vector<int>& cpus)
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    if (cpus.empty())
+        return;
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (auto cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &cpu_set);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#endif
+}
+
+void set_this_thread_name(const std::string& name)
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    if (name.empty())
+        return;
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#endif
+}
+
+} // namespace server_lib
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace server_lib {
+
+/**
+ * \brief NUMA nodes and their CPUs (/sys/devices/system/node)
+ *
+ * Online nodes with CPUs are indexed in order (node numbers
+ * could be sparse). Single node with all CPUs if system
+ * doesn't report nodes.
+ */
+class numa_topology
+{
+public:
+    static const numa_topology& instance();
+
+    size_t nodes_count() const
+    {
+        return _nodes.size();
+    }
+
+    const std::vector<int>& node_cpus(size_t node) const
+    {
+        return _nodes[node % _nodes.size()];
+    }
+
+    // Zero if CPU is unknown
+    size_t node_of_cpu(int cpu) const;
+    // Node of CPU the calling thread is running on
+    size_t current_node() const;
+
+private:
+    numa_topology();
+
+    std::vector<std::vector<int>> _nodes;
+};
+
+// Parses cpulist format ("0-3,8,10-11"), node lists too
+std::vector<int> parse_cpu_list(const std::string& list);
+
+// Restricts calling thread to CPUs. Does nothing if empty
+void set_this_thread_affinity(const std::vector<int>& cpus);
+// Kernel truncates name to 15 characters. Does nothing if empty
+void set_this_thread_name(const std::string& name);
+
+} // namespace server_lib
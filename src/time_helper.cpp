@@ -10,79 +10,400 @@
 #include <iomanip> // std::put_time, std::get_time
 #include <sstream>
 #endif //< !SERVER_LIB_PLATFORM_MOBILE
+#include <cerrno>
 #include <chrono>
+#include <cstring>
+#include <limits>
 
 
 namespace server_lib {
 
+namespace {
 #if !defined(SERVER_LIB_PLATFORM_MOBILE)
 #if !defined(SERVER_LIB_PLATFORM_WINDOWS)
-time_t from_iso_string(const std::string& formatted, const char* format, bool should_utc)
-{
-    std::stringstream ss;
+    bool generic_from_iso_string(const std::string& formatted, const char* format, bool should_utc, time_t& result)
+    {
+        std::stringstream ss;
 
-    ss << formatted;
+        ss << formatted;
 
-    std::tm tp {};
+        std::tm tp {};
 
-    ss >> std::get_time(&tp, format);
-    if (!ss.fail())
+        ss >> std::get_time(&tp, format);
+        if (!ss.fail())
+        {
+            // Let mktime find DST
+            tp.tm_isdst = -1;
+            time_t r = std::mktime(&tp);
+            result = (should_utc) ? (r + tp.tm_gmtoff) : (r);
+            return true;
+        }
+        return false;
+    }
+#else //< !SERVER_LIB_PLATFORM_WINDOWS
+    bool generic_from_iso_string(const std::string& formatted, const char* format, bool should_utc, time_t& result)
     {
+        std::stringstream ss;
+
+        ss << formatted;
+
+        std::tm tp {};
+
+        ss >> std::get_time(&tp, format);
+        if (!ss.fail())
+        {
+            result = (should_utc) ? _mkgmtime(&tp) : std::mktime(&tp);
+            return true;
+        }
+        return false;
+    }
+#endif //< SERVER_LIB_PLATFORM_WINDOWS
+#else //< !SERVER_LIB_PLATFORM_MOBILE
+    bool generic_from_iso_string(const std::string& formatted, const char* format, bool should_utc, time_t& result)
+    {
+        std::tm tp {};
+
+        auto call_r = strptime(formatted.c_str(), format, &tp);
+        if (call_r == NULL)
+            return false;
+
+        tp.tm_isdst = -1;
         time_t r = std::mktime(&tp);
-        return (should_utc) ? (r + tp.tm_gmtoff) : (r);
+        result = (should_utc) ? (r + tp.tm_gmtoff) : (r);
+        return true;
     }
-    return {};
-}
-#else //< !SERVER_LIB_PLATFORM_WINDOWS
-time_t from_iso_string(const std::string& formatted, const char* format, bool should_utc)
-{
-    std::stringstream ss;
+#endif //< SERVER_LIB_PLATFORM_MOBILE
 
-    ss << formatted;
+    bool to_tm(const time_t t, bool should_utc, std::tm& result)
+    {
+#if defined(SERVER_LIB_PLATFORM_WINDOWS)
+        return ((should_utc) ? gmtime_s(&result, &t) : localtime_s(&result, &t)) == 0;
+#else
+        return ((should_utc) ? gmtime_r(&t, &result) : localtime_r(&t, &result)) != nullptr;
+#endif
+    }
 
-    std::tm tp {};
+    // Civil calendar (proleptic Gregorian) without libc
+    int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+    {
+        y -= m <= 2;
+        const int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
 
-    ss >> std::get_time(&tp, format);
-    if (!ss.fail())
+    void civil_from_days(int64_t z, int64_t& y, unsigned& m, unsigned& d)
     {
-        return (should_utc) ? _mkgmtime(&tp) : std::mktime(&tp);
+        z += 719468;
+        const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
     }
-    return {};
-}
-#endif //< SERVER_LIB_PLATFORM_WINDOWS
 
-std::string to_iso_string(const time_t t, const char* format, bool should_utc)
-{
-    std::stringstream ss;
+    int64_t floor_div(int64_t value, int64_t divider)
+    {
+        return (value >= 0) ? value / divider : -((-value + divider - 1) / divider);
+    }
 
-    ss << std::put_time((should_utc) ? std::gmtime(&t) : std::localtime(&t), format);
+    // Time zone set by the last tzset (zone names are kept by libc)
+    struct zone_type
+    {
+        const void* standard_name = nullptr;
+        const void* daylight_name = nullptr;
+        long standard_offset = 0;
 
-    return ss.str();
-}
-#else //< !SERVER_LIB_PLATFORM_MOBILE
-time_t from_iso_string(const std::string& formatted, const char* format, bool should_utc)
+        bool operator!=(const zone_type& other) const
+        {
+            return standard_name != other.standard_name || daylight_name != other.daylight_name
+                || standard_offset != other.standard_offset;
+        }
+    };
+
+    zone_type current_zone()
+    {
+        zone_type result;
+#if !defined(SERVER_LIB_PLATFORM_WINDOWS)
+        result.standard_name = tzname[0];
+        result.daylight_name = tzname[1];
+        result.standard_offset = timezone;
+#endif
+        return result;
+    }
+
+    // Offset of local time. Time zone rules change it at quarter
+    // hour boundaries of UTC (for +05:30, +05:45 zones too),
+    // so it is cached per quarter hour and per time zone
+    bool local_offset(int64_t t, int64_t& offset)
+    {
+        struct cache_type
+        {
+            int64_t quarter = std::numeric_limits<int64_t>::min();
+            zone_type zone;
+            int64_t offset = 0;
+        };
+        thread_local cache_type cache;
+
+        const int64_t quarter = floor_div(t, 900);
+        const auto zone = current_zone();
+        if (quarter != cache.quarter || zone != cache.zone)
+        {
+            std::tm local {};
+            if (!to_tm(static_cast<time_t>(t), false, local))
+                return false;
+            const int64_t local_seconds = days_from_civil(local.tm_year + 1900, static_cast<unsigned>(local.tm_mon + 1), static_cast<unsigned>(local.tm_mday)) * 86400
+                + local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+            cache.offset = local_seconds - t;
+            cache.quarter = quarter;
+            cache.zone = zone;
+        }
+        offset = cache.offset;
+        return true;
+    }
+
+    // Format of %Y %m %d %H %M %S and separators only
+    bool is_fixed_format(const char* format)
+    {
+        for (const char* p = format; *p; ++p)
+        {
+            if (*p != '%')
+            {
+                if (*p == '-' || *p == ':' || *p == 'T' || *p == ' ' || *p == '/' || *p == '.' || *p == '_')
+                    continue;
+                return false;
+            }
+            switch (*++p)
+            {
+            case 'Y':
+            case 'm':
+            case 'd':
+            case 'H':
+            case 'M':
+            case 'S':
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parse_digits(const char*& p, const char* end, size_t count, int& value)
+    {
+        if (static_cast<size_t>(end - p) < count)
+            return false;
+        int result = 0;
+        unsigned invalid = 0;
+        for (size_t ci = 0; ci < count; ++ci)
+        {
+            const unsigned digit = static_cast<unsigned>(p[ci] - '0');
+            invalid |= (digit > 9);
+            result = result * 10 + static_cast<int>(digit);
+        }
+        p += count;
+        value = result;
+        return !invalid;
+    }
+
+    const char digit_pairs[] = "00010203040506070809"
+                               "10111213141516171819"
+                               "20212223242526272829"
+                               "30313233343536373839"
+                               "40414243444546474849"
+                               "50515253545556575859"
+                               "60616263646566676869"
+                               "70717273747576777879"
+                               "80818283848586878889"
+                               "90919293949596979899";
+
+    void put_two_digits(char* p, unsigned value)
+    {
+        memcpy(p, digit_pairs + 2 * value, 2);
+    }
+
+    bool fast_parse(const char* formatted, size_t size, const char* format, bool should_utc, time_t& result)
+    {
+        const char* p = formatted;
+        const char* end = formatted + size;
+        int year = 1900, month = 1, day = 1, hour = 0, minute = 0, second = 0;
+        for (const char* f = format; *f; ++f)
+        {
+            if (*f != '%')
+            {
+                if (p == end || *p != *f)
+                    return false;
+                ++p;
+                continue;
+            }
+            bool ok = false;
+            switch (*++f)
+            {
+            case 'Y':
+                ok = parse_digits(p, end, 4, year);
+                break;
+            case 'm':
+                ok = parse_digits(p, end, 2, month);
+                break;
+            case 'd':
+                ok = parse_digits(p, end, 2, day);
+                break;
+            case 'H':
+                ok = parse_digits(p, end, 2, hour);
+                break;
+            case 'M':
+                ok = parse_digits(p, end, 2, minute);
+                break;
+            case 'S':
+                ok = parse_digits(p, end, 2, second);
+                break;
+            default:;
+            }
+            if (!ok)
+                return false;
+        }
+        if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+            return false;
+
+        const int64_t value = days_from_civil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400
+            + hour * 3600 + minute * 60 + second;
+        if (should_utc)
+        {
+            result = static_cast<time_t>(value);
+            return true;
+        }
+
+        // Offset at the result time (not at local value)
+        int64_t offset = 0;
+        if (!local_offset(value, offset))
+            return false;
+        int64_t corrected = 0;
+        if (!local_offset(value - offset, corrected))
+            return false;
+        result = static_cast<time_t>(value - corrected);
+        return true;
+    }
+
+    int fast_format(const time_t t, const char* format, char* buffer, size_t capacity, size_t& size, bool should_utc)
+    {
+        int64_t value = static_cast<int64_t>(t);
+        if (!should_utc)
+        {
+            int64_t offset = 0;
+            if (!local_offset(value, offset))
+                return EINVAL;
+            value += offset;
+        }
+
+        const int64_t days = floor_div(value, 86400);
+        const int64_t seconds = value - days * 86400;
+        int64_t year = 0;
+        unsigned month = 0, day = 0;
+        civil_from_days(days, year, month, day);
+        if (year < 0 || year > 9999)
+            return EINVAL;
+
+        char* p = buffer;
+        char* end = buffer + capacity;
+        for (const char* f = format; *f; ++f)
+        {
+            const size_t need = (*f != '%') ? 1 : ((f[1] == 'Y') ? 4 : 2);
+            if (static_cast<size_t>(end - p) < need)
+                return ERANGE;
+            if (*f != '%')
+            {
+                *p++ = *f;
+                continue;
+            }
+            switch (*++f)
+            {
+            case 'Y':
+                put_two_digits(p, static_cast<unsigned>(year / 100));
+                put_two_digits(p + 2, static_cast<unsigned>(year % 100));
+                break;
+            case 'm':
+                put_two_digits(p, month);
+                break;
+            case 'd':
+                put_two_digits(p, day);
+                break;
+            case 'H':
+                put_two_digits(p, static_cast<unsigned>(seconds / 3600));
+                break;
+            case 'M':
+                put_two_digits(p, static_cast<unsigned>(seconds / 60 % 60));
+                break;
+            case 'S':
+                put_two_digits(p, static_cast<unsigned>(seconds % 60));
+                break;
+            default:;
+            }
+            p += need;
+        }
+        size = static_cast<size_t>(p - buffer);
+        return 0;
+    }
+} // namespace
+
+int parse_iso_time(const char* formatted, size_t size, const char* format, time_t& result, bool should_utc)
 {
-    std::tm tp {};
+    if (!formatted || !format)
+        return EINVAL;
+    if (is_fixed_format(format) && fast_parse(formatted, size, format, should_utc, result))
+        return 0;
+    // Generic path accepts more (like single digit fields)
+    if (generic_from_iso_string(std::string(formatted, size), format, should_utc, result))
+        return 0;
+    return EINVAL;
+}
 
-    auto call_r = strptime(formatted.c_str(), format, &tp);
+int format_iso_time(const time_t t, const char* format, char* buffer, size_t capacity, size_t& size, bool should_utc)
+{
+    if (!format || !buffer)
+        return EINVAL;
+    if (is_fixed_format(format))
+        return fast_format(t, format, buffer, capacity, size, should_utc);
 
-    SRV_ASSERT(call_r != NULL, "Can't parse time");
+    std::tm tp {};
+    if (!to_tm(t, should_utc, tp))
+        return EINVAL;
+    if (!*format)
+    {
+        size = 0;
+        return 0;
+    }
+    size = std::strftime(buffer, capacity, format, &tp);
+    return (size > 0) ? 0 : ERANGE;
+}
 
-    time_t r = std::mktime(&tp);
-    return (should_utc) ? (r + tp.tm_gmtoff) : (r);
+time_t from_iso_string(const std::string& formatted, const char* format, bool should_utc)
+{
+    time_t result = {};
+    if (parse_iso_time(formatted.data(), formatted.size(), format, result, should_utc))
+        return {};
+    return result;
 }
 
 std::string to_iso_string(const time_t t, const char* format, bool should_utc)
 {
     char buff[100];
+    size_t size = 0;
+    auto error = format_iso_time(t, format, buff, sizeof(buff), size, should_utc);
+    if (!error)
+        return { buff, size };
+    if (error != ERANGE)
+        return {};
 
-    auto call_r = std::strftime(buff, sizeof(buff), format,
-                                (should_utc) ? std::gmtime(&t) : std::localtime(&t));
-
-    SRV_ASSERT(call_r > 0, "Can't format time");
-
-    return { buff };
+    std::string result(4096, '\0');
+    if (format_iso_time(t, format, &result[0], result.size(), size, should_utc))
+        return {};
+    result.resize(size);
+    return result;
 }
-#endif //< SERVER_LIB_PLATFORM_MOBILE
 
 } // namespace server_lib
@@ -0,0 +1,182 @@
+#include "tsc_clock.h"
+
+#if defined(SRV_TSC_SUPPORTED)
+#include <cpuid.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace server_lib {
+
+namespace {
+    // Short spin at first use. Rate is refined by next calibrations
+    const std::chrono::milliseconds initial_calibration(5);
+    const std::chrono::seconds calibration_period(1);
+
+    bool is_tsc_invariant()
+    {
+#if defined(SRV_TSC_SUPPORTED)
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+            return false;
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+            return false;
+        // Invariant TSC flag
+        return (edx & (1u << 8)) != 0;
+#else
+        return false;
+#endif
+    }
+} // namespace
+
+tsc_clock& tsc_clock::instance()
+{
+    static tsc_clock clock;
+    return clock;
+}
+
+tsc_clock::tsc_clock()
+{
+    _use_tsc = is_tsc_invariant();
+
+    int64_t anchor_real_ns = 0;
+    read_clocks(_anchor_ticks, _anchor_raw_ns, anchor_real_ns);
+
+    double ns_per_tick = 1.0;
+    if (_use_tsc)
+    {
+        const int64_t calibration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(initial_calibration).count();
+        uint64_t ticks = 0;
+        int64_t raw_ns = 0;
+        int64_t real_ns = 0;
+        do
+        {
+            read_clocks(ticks, raw_ns, real_ns);
+        } while (raw_ns - _anchor_raw_ns < calibration_ns);
+
+        ns_per_tick = static_cast<double>(raw_ns - _anchor_raw_ns) / static_cast<double>(ticks - _anchor_ticks);
+    }
+
+    _base_ticks.store(_anchor_ticks, std::memory_order_relaxed);
+    _base_ns.store(anchor_real_ns, std::memory_order_relaxed);
+    _ns_per_tick.store(ns_per_tick, std::memory_order_relaxed);
+
+    _calibration_period_ticks = to_ticks(calibration_period);
+    _next_calibration_ticks.store(_anchor_ticks + _calibration_period_ticks, std::memory_order_release);
+}
+
+tsc_clock::time_point tsc_clock::to_time_point(uint64_t ticks)
+{
+    if (ticks >= _next_calibration_ticks.load(std::memory_order_relaxed))
+        recalibrate(ticks);
+
+    uint64_t seq = 0;
+    uint64_t base_ticks = 0;
+    int64_t base_ns = 0;
+    double ns_per_tick = 1.0;
+    do
+    {
+        seq = _seq.load(std::memory_order_acquire);
+        base_ticks = _base_ticks.load(std::memory_order_relaxed);
+        base_ns = _base_ns.load(std::memory_order_relaxed);
+        ns_per_tick = _ns_per_tick.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != _seq.load(std::memory_order_relaxed));
+
+    // Ticks could be captured before the base
+    const int64_t delta_ticks = static_cast<int64_t>(ticks - base_ticks);
+    const int64_t ns = base_ns + std::llround(static_cast<double>(delta_ticks) * ns_per_tick);
+
+    auto last_ns = _last_ns.load(std::memory_order_relaxed);
+    while (ns > last_ns && !_last_ns.compare_exchange_weak(last_ns, ns, std::memory_order_relaxed))
+        ;
+
+    return time_point(std::chrono::duration_cast<time_point::duration>(std::chrono::nanoseconds(ns)));
+}
+
+uint64_t tsc_clock::to_ticks(std::chrono::nanoseconds duration) const
+{
+    return static_cast<uint64_t>(static_cast<double>(duration.count()) / _ns_per_tick.load(std::memory_order_relaxed));
+}
+
+std::chrono::nanoseconds tsc_clock::to_duration(uint64_t ticks) const
+{
+    return std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(ticks) * _ns_per_tick.load(std::memory_order_relaxed)));
+}
+
+int64_t tsc_clock::realtime_ns()
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + static_cast<int64_t>(ts.tv_nsec);
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+int64_t tsc_clock::monotonic_raw_ns()
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + static_cast<int64_t>(ts.tv_nsec);
+#else
+    return static_cast<int64_t>(monotonic_ns());
+#endif
+}
+
+void tsc_clock::read_clocks(uint64_t& ticks, int64_t& raw_ns, int64_t& real_ns) const
+{
+    // The tightest of several readings
+    uint64_t best_gap = std::numeric_limits<uint64_t>::max();
+    for (int ci = 0; ci < 3; ++ci)
+    {
+        const uint64_t before = now();
+        const int64_t raw = monotonic_raw_ns();
+        const int64_t real = realtime_ns();
+        const uint64_t after = now();
+        if (after - before < best_gap)
+        {
+            best_gap = after - before;
+            ticks = before + (after - before) / 2;
+            raw_ns = raw;
+            real_ns = real;
+        }
+    }
+}
+
+void tsc_clock::recalibrate(uint64_t ticks)
+{
+    std::unique_lock<std::mutex> lock(_calibration_mutex, std::try_to_lock);
+    if (!lock.owns_lock() || ticks < _next_calibration_ticks.load(std::memory_order_relaxed))
+        return;
+
+    uint64_t now_ticks = 0;
+    int64_t raw_ns = 0;
+    int64_t now_ns = 0;
+    read_clocks(now_ticks, raw_ns, now_ns);
+
+    double ns_per_tick = _ns_per_tick.load(std::memory_order_relaxed);
+    if (_use_tsc && now_ticks > _anchor_ticks)
+        ns_per_tick = static_cast<double>(raw_ns - _anchor_raw_ns) / static_cast<double>(now_ticks - _anchor_ticks);
+
+    // Converted time never goes back if real time is stepped back
+    now_ns = std::max(now_ns, _last_ns.load(std::memory_order_relaxed));
+
+    const uint64_t seq = _seq.load(std::memory_order_relaxed);
+    _seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _base_ticks.store(now_ticks, std::memory_order_relaxed);
+    _base_ns.store(now_ns, std::memory_order_relaxed);
+    _ns_per_tick.store(ns_per_tick, std::memory_order_relaxed);
+    _seq.store(seq + 2, std::memory_order_release);
+
+    _next_calibration_ticks.store(now_ticks + _calibration_period_ticks, std::memory_order_relaxed);
+}
+
+} // namespace server_lib
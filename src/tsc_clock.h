@@ -0,0 +1,104 @@
+#pragma once
+
+#include <logger/platform_config.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define SRV_TSC_SUPPORTED
+#endif
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <time.h>
+#endif
+
+namespace server_lib {
+
+/**
+ * \brief Cheap clock for call site timestamps
+ *
+ * Reads raw TSC if it is invariant. Otherwise reads monotonic clock
+ * (nanoseconds). Raw value is converted to wall-clock later
+ * (at backend thread) by calibration: rate is measured against
+ * CLOCK_MONOTONIC_RAW (not stepped or slewed by NTP), real time
+ * offset is taken at every periodic rebase. Rebase never moves
+ * converted time below the last value handed out.
+ */
+class tsc_clock
+{
+public:
+    using time_point = std::chrono::system_clock::time_point;
+
+    static tsc_clock& instance();
+
+    uint64_t now() const
+    {
+#if defined(SRV_TSC_SUPPORTED)
+        if (_use_tsc)
+            return __rdtsc();
+#endif
+        return monotonic_ns();
+    }
+
+    time_point to_time_point(uint64_t ticks);
+
+    uint64_t to_ticks(std::chrono::nanoseconds duration) const;
+
+    std::chrono::nanoseconds to_duration(uint64_t ticks) const;
+
+    bool use_tsc() const
+    {
+        return _use_tsc;
+    }
+
+private:
+    tsc_clock();
+
+    static uint64_t monotonic_ns()
+    {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + static_cast<uint64_t>(ts.tv_nsec);
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+#endif
+    }
+
+    static int64_t realtime_ns();
+
+    static int64_t monotonic_raw_ns();
+
+    // Simultaneous reading of raw clock, monotonic raw and real time
+    void read_clocks(uint64_t& ticks, int64_t& raw_ns, int64_t& real_ns) const;
+
+    void recalibrate(uint64_t ticks);
+
+private:
+    bool _use_tsc = false;
+
+    // First reading as long baseline for rate
+    uint64_t _anchor_ticks = 0;
+    int64_t _anchor_raw_ns = 0;
+
+    // Seqlock protected calibration
+    std::atomic<uint64_t> _seq { 0 };
+    std::atomic<uint64_t> _base_ticks { 0 };
+    std::atomic<int64_t> _base_ns { 0 };
+    std::atomic<double> _ns_per_tick { 1.0 };
+
+    // The latest converted time
+    std::atomic<int64_t> _last_ns { 0 };
+
+    std::atomic<uint64_t> _next_calibration_ticks { 0 };
+    uint64_t _calibration_period_ticks = 0;
+    std::mutex _calibration_mutex;
+};
+
+} // namespace server_lib
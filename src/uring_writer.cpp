@@ -0,0 +1,377 @@
+#include "uring_writer.h"
+
+#include <logger/platform_config.h>
+#include <logger/asserts.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace server_lib {
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+namespace {
+    const size_t page_size = 4096;
+    // Idle SQPOLL thread goes to sleep after this period
+    const unsigned sqpoll_idle_ms = 1000;
+
+    unsigned load_acquire(const unsigned* p)
+    {
+        return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+
+    void store_release(unsigned* p, unsigned value)
+    {
+        __atomic_store_n(p, value, __ATOMIC_RELEASE);
+    }
+
+    template <typename T>
+    T* at(void* base, size_t offset)
+    {
+        return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+    }
+
+    int setup(unsigned entries, io_uring_params& params, bool sqpoll)
+    {
+        memset(&params, 0, sizeof(params));
+        if (sqpoll)
+        {
+            params.flags = IORING_SETUP_SQPOLL;
+            params.sq_thread_idle = sqpoll_idle_ms;
+        }
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    }
+} // namespace
+
+uring_writer::uring_writer(size_t buffers_count, size_t buffer_size, bool sqpoll)
+    : _buffer_size((buffer_size + page_size - 1) & ~(page_size - 1))
+{
+    SRV_ASSERT(buffers_count > 0 && buffer_size > 0, "Invalid io_uring buffers");
+
+    const auto entries = static_cast<unsigned>(buffers_count);
+    io_uring_params params;
+    _sqpoll = sqpoll;
+    _fd = setup(entries, params, _sqpoll);
+    if (_fd < 0 && _sqpoll)
+    {
+        // SQPOLL could require privileges on older kernels
+        _sqpoll = false;
+        _fd = setup(entries, params, false);
+    }
+    SRV_ASSERT(_fd >= 0, "io_uring is unavailable");
+
+    _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap)
+        _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+
+    _sq_ptr = mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+    if (_sq_ptr == MAP_FAILED)
+        _sq_ptr = nullptr;
+    if (single_mmap)
+    {
+        _cq_ptr = _sq_ptr;
+    }
+    else if (_sq_ptr)
+    {
+        _cq_ptr = mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+        if (_cq_ptr == MAP_FAILED)
+            _cq_ptr = nullptr;
+    }
+    _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    if (_cq_ptr)
+    {
+        _sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+        if (_sqes == MAP_FAILED)
+            _sqes = nullptr;
+    }
+    if (!_sqes)
+    {
+        unmap();
+        SRV_ERROR("Can't map io_uring");
+    }
+
+    _sq_head = at<unsigned>(_sq_ptr, params.sq_off.head);
+    _sq_tail = at<unsigned>(_sq_ptr, params.sq_off.tail);
+    _sq_mask = at<unsigned>(_sq_ptr, params.sq_off.ring_mask);
+    _sq_flags = at<unsigned>(_sq_ptr, params.sq_off.flags);
+    _sq_array = at<unsigned>(_sq_ptr, params.sq_off.array);
+    _cq_head = at<unsigned>(_cq_ptr, params.cq_off.head);
+    _cq_tail = at<unsigned>(_cq_ptr, params.cq_off.tail);
+    _cq_mask = at<unsigned>(_cq_ptr, params.cq_off.ring_mask);
+    _cqes = at<void>(_cq_ptr, params.cq_off.cqes);
+
+    void* memory = nullptr;
+    if (posix_memalign(&memory, page_size, _buffer_size * buffers_count) != 0)
+    {
+        unmap();
+        SRV_ERROR("Can't allocate io_uring buffers");
+    }
+    _memory = static_cast<char*>(memory);
+
+    _slots.resize(buffers_count);
+    std::vector<iovec> iovs(buffers_count);
+    for (size_t ci = 0; ci < buffers_count; ++ci)
+    {
+        _slots[ci].data = _memory + ci * _buffer_size;
+        iovs[ci].iov_base = _slots[ci].data;
+        iovs[ci].iov_len = _buffer_size;
+    }
+
+    // Pinned pages could be limited (RLIMIT_MEMLOCK). Then buffers are
+    // passed with every write
+    _fixed = syscall(__NR_io_uring_register, _fd, IORING_REGISTER_BUFFERS, iovs.data(), static_cast<unsigned>(iovs.size())) == 0;
+}
+
+uring_writer::~uring_writer()
+{
+    try
+    {
+        wait_all();
+    }
+    catch (std::exception&)
+    {
+    }
+    unmap();
+    free(_memory);
+}
+
+void uring_writer::unmap()
+{
+    if (_sqes)
+        munmap(_sqes, _sqes_size);
+    if (_cq_ptr && _cq_ptr != _sq_ptr)
+        munmap(_cq_ptr, _cq_size);
+    if (_sq_ptr)
+        munmap(_sq_ptr, _sq_size);
+    _sqes = _cq_ptr = _sq_ptr = nullptr;
+    if (_fd >= 0)
+        close(_fd);
+    _fd = -1;
+}
+
+size_t uring_writer::acquire()
+{
+    for (;;)
+    {
+        for (size_t ci = 0; ci < _slots.size(); ++ci)
+        {
+            if (!_slots[ci].busy)
+                return ci;
+        }
+        submit();
+        reap(true);
+    }
+}
+
+char* uring_writer::buffer(size_t index)
+{
+    return _slots[index].data;
+}
+
+void uring_writer::write(int fd, size_t index, size_t size, uint64_t offset, uint64_t sequence)
+{
+    SRV_ASSERT(index < _slots.size() && size <= _buffer_size);
+
+    auto& current = _slots[index];
+    current.fd = fd;
+    current.size = size;
+    current.offset = offset;
+    current.sequence = sequence;
+    current.busy = true;
+    ++_in_flight;
+
+    // SQ can't be full: every buffer has one entry at most
+    const unsigned tail = *_sq_tail;
+    const unsigned position = tail & *_sq_mask;
+    auto sqe = static_cast<io_uring_sqe*>(_sqes) + position;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = _fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(current.data);
+    sqe->len = static_cast<uint32_t>(size);
+    sqe->off = offset;
+    sqe->buf_index = static_cast<uint16_t>(_fixed ? index : 0);
+    sqe->user_data = index;
+    _sq_array[position] = position;
+    store_release(_sq_tail, tail + 1);
+    ++_to_submit;
+}
+
+void uring_writer::submit()
+{
+    if (!_to_submit)
+        return;
+
+    if (_sqpoll)
+    {
+        // Kernel thread is polling unless it fell asleep
+        if (load_acquire(_sq_flags) & IORING_SQ_NEED_WAKEUP)
+            enter(0, 0, IORING_ENTER_SQ_WAKEUP);
+        _to_submit = 0;
+        return;
+    }
+
+    while (_to_submit)
+    {
+        const int submitted = enter(_to_submit, 0, 0);
+        if (submitted < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+            {
+                reap(false);
+                continue;
+            }
+            SRV_ERROR("Can't submit to io_uring");
+        }
+        _to_submit -= std::min(_to_submit, static_cast<unsigned>(submitted));
+    }
+}
+
+void uring_writer::reap(bool wait)
+{
+    for (;;)
+    {
+        unsigned head = *_cq_head;
+        const unsigned tail = load_acquire(_cq_tail);
+        if (head != tail)
+        {
+            for (; head != tail; ++head)
+            {
+                auto cqe = static_cast<io_uring_cqe*>(_cqes) + (head & *_cq_mask);
+                const auto index = static_cast<size_t>(cqe->user_data);
+                const int result = cqe->res;
+                store_release(_cq_head, head + 1);
+                complete(index, result);
+            }
+            return;
+        }
+        if (!wait || !_in_flight)
+            return;
+
+        unsigned flags = IORING_ENTER_GETEVENTS;
+        if (_sqpoll && (load_acquire(_sq_flags) & IORING_SQ_NEED_WAKEUP))
+            flags |= IORING_ENTER_SQ_WAKEUP;
+        if (enter(0, 1, flags) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            SRV_ERROR("Can't wait for io_uring");
+    }
+}
+
+void uring_writer::wait_all()
+{
+    submit();
+    while (_in_flight)
+    {
+        reap(true);
+    }
+}
+
+uint64_t uring_writer::oldest_in_flight(uint64_t none_value) const
+{
+    uint64_t result = none_value;
+    for (const auto& current : _slots)
+    {
+        if (current.busy)
+            result = std::min(result, current.sequence);
+    }
+    return result;
+}
+
+int uring_writer::enter(unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, _fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+void uring_writer::complete(size_t index, int result)
+{
+    SRV_ASSERT(index < _slots.size());
+
+    auto& current = _slots[index];
+    // Short write is finished synchronously (disk is full or alike)
+    size_t written = (result > 0) ? static_cast<size_t>(result) : 0;
+    while (result >= 0 && written < current.size)
+    {
+        auto ln = pwrite(current.fd, current.data + written, current.size - written,
+                         static_cast<off_t>(current.offset + written));
+        if (ln < 0 && errno == EINTR)
+            continue;
+        if (ln <= 0)
+        {
+            result = -1;
+            break;
+        }
+        written += static_cast<size_t>(ln);
+    }
+
+    current.busy = false;
+    --_in_flight;
+    if (result < 0)
+        SRV_ERROR("Can't write log file");
+}
+#else // SERVER_LIB_PLATFORM_LINUX
+uring_writer::uring_writer(size_t, size_t buffer_size, bool)
+    : _buffer_size(buffer_size)
+{
+    SRV_ERROR("Not implemented");
+}
+
+uring_writer::~uring_writer()
+{
+}
+
+size_t uring_writer::acquire()
+{
+    return 0;
+}
+
+char* uring_writer::buffer(size_t)
+{
+    return nullptr;
+}
+
+void uring_writer::write(int, size_t, size_t, uint64_t, uint64_t)
+{
+}
+
+void uring_writer::submit()
+{
+}
+
+void uring_writer::reap(bool)
+{
+}
+
+void uring_writer::wait_all()
+{
+}
+
+uint64_t uring_writer::oldest_in_flight(uint64_t none_value) const
+{
+    return none_value;
+}
+
+int uring_writer::enter(unsigned, unsigned, unsigned)
+{
+    return -1;
+}
+
+void uring_writer::complete(size_t, int)
+{
+}
+
+void uring_writer::unmap()
+{
+}
+#endif // !SERVER_LIB_PLATFORM_LINUX
+
+} // namespace server_lib
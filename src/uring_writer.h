@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace server_lib {
+
+/**
+ * \brief Writes of registered buffers through io_uring
+ *
+ * Raw system calls (no liburing). Every buffer is registered
+ * once (fixed buffer) and is busy until its write is completed,
+ * so completions recycle buffers. Writes are made at explicit
+ * offsets, so they could complete in any order.
+ *
+ * With SQPOLL the kernel thread takes submissions and
+ * the system call is only made to wake it up.
+ */
+class uring_writer
+{
+public:
+    // Throws if io_uring is unavailable. Falls back to
+    // ordinary submission if SQPOLL is not permitted
+    uring_writer(size_t buffers_count, size_t buffer_size, bool sqpoll);
+    ~uring_writer();
+
+    uring_writer(const uring_writer&) = delete;
+    uring_writer& operator=(const uring_writer&) = delete;
+
+    size_t buffer_size() const
+    {
+        return _buffer_size;
+    }
+
+    bool sqpoll() const
+    {
+        return _sqpoll;
+    }
+
+    // Index of free buffer. Waits for completion if all are busy
+    size_t acquire();
+    char* buffer(size_t index);
+
+    // Queues write of buffer [0, size) to file offset.
+    // Sequence is reported by oldest_in_flight
+    void write(int fd, size_t index, size_t size, uint64_t offset, uint64_t sequence);
+    // Passes queued writes to kernel
+    void submit();
+
+    // Recycles buffers of completed writes. Waits for one if required.
+    // Throws if write failed
+    void reap(bool wait);
+    void wait_all();
+
+    size_t in_flight() const
+    {
+        return _in_flight;
+    }
+
+    // Minimal sequence of writes in flight or none_value
+    uint64_t oldest_in_flight(uint64_t none_value) const;
+
+private:
+    struct slot
+    {
+        char* data = nullptr;
+        int fd = -1;
+        size_t size = 0;
+        uint64_t offset = 0;
+        uint64_t sequence = 0;
+        bool busy = false;
+    };
+
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+    void complete(size_t index, int result);
+    void unmap();
+
+private:
+    const size_t _buffer_size;
+    bool _sqpoll = false;
+    bool _fixed = false;
+    int _fd = -1;
+
+    void* _sq_ptr = nullptr;
+    size_t _sq_size = 0;
+    void* _cq_ptr = nullptr;
+    size_t _cq_size = 0;
+    void* _sqes = nullptr;
+    size_t _sqes_size = 0;
+
+    // Pointers into mapped rings
+    unsigned* _sq_head = nullptr;
+    unsigned* _sq_tail = nullptr;
+    unsigned* _sq_mask = nullptr;
+    unsigned* _sq_flags = nullptr;
+    unsigned* _sq_array = nullptr;
+    unsigned* _cq_head = nullptr;
+    unsigned* _cq_tail = nullptr;
+    unsigned* _cq_mask = nullptr;
+    void* _cqes = nullptr;
+
+    char* _memory = nullptr;
+    std::vector<slot> _slots;
+    size_t _in_flight = 0;
+    unsigned _to_submit = 0;
+};
+
+} // namespace server_lib
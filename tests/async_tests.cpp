@@ -0,0 +1,386 @@
+#include "tests_common.h"
+#include "thread_affinity.h"
+
+#include <logger/ll.h>
+
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <set>
+
+#include <pthread.h>
+#include <poll.h>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        // Read "<thread> <counter>" lines and check counters are ordered per thread
+        size_t check_ordered_per_thread(const std::string& file_path)
+        {
+            std::ifstream input(file_path);
+
+            std::map<int, int> last_counters;
+            size_t rows = 0;
+            for (std::string line; std::getline(input, line); ++rows)
+            {
+                std::istringstream ss(line);
+                int thread_index = -1, counter = -1;
+                ss >> thread_index >> counter;
+                BOOST_REQUIRE(!ss.fail());
+
+                auto it = last_counters.find(thread_index);
+                if (it != last_counters.end())
+                {
+                    BOOST_REQUIRE_EQUAL(it->second + 1, counter);
+                    it->second = counter;
+                }
+                else
+                {
+                    BOOST_REQUIRE_EQUAL(counter, 0);
+                    last_counters.emplace(thread_index, counter);
+                }
+            }
+            return rows;
+        }
+    } // namespace
+
+    BOOST_FIXTURE_TEST_SUITE(async_tests, logger_cleanup)
+
+    BOOST_AUTO_TEST_CASE(async_per_thread_order_check)
+    {
+        print_current_test_name();
+
+        logger::async_options options;
+        options.flushers = 3;
+        options.queue_capacity = 64;
+
+        logger::instance().init_cli_log().set_details(logger::details_message_only).init_async_log(options);
+
+        BOOST_REQUIRE(logger::instance().is_async());
+
+        create_log_file(current_test_name());
+
+        static const int threads_count = 4;
+        static const int messages_count = 1000;
+
+        std::vector<std::thread> threads;
+        for (int ci = 0; ci < threads_count; ++ci)
+        {
+            threads.emplace_back([ci]() {
+                for (int cj = 0; cj < messages_count; ++cj)
+                {
+                    LOG_INFO(ci << ' ' << cj);
+                }
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+
+        logger::instance().flush();
+
+        BOOST_REQUIRE_EQUAL(check_ordered_per_thread(close_log_file()), threads_count * messages_count);
+    }
+
+    BOOST_AUTO_TEST_CASE(async_drain_on_destroy_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_details(logger::details_message_only).init_async_log();
+
+        create_log_file(current_test_name());
+
+        static const int messages_count = 100;
+
+        for (int ci = 0; ci < messages_count; ++ci)
+        {
+            LOG_DEBUG(0 << ' ' << ci);
+        }
+
+        logger::destroy();
+
+        BOOST_REQUIRE_EQUAL(check_ordered_per_thread(close_log_file()), messages_count);
+    }
+
+    BOOST_AUTO_TEST_CASE(async_merge_by_time_check)
+    {
+        print_current_test_name();
+
+        logger::async_options options;
+        options.reorder_window = std::chrono::milliseconds(50);
+        // Ring of 256K bytes holds all small records
+        // of thread and spills huge ones
+        options.queue_capacity = 1024;
+
+        std::vector<logger::log_context> written;
+        logger::instance().add_destination([&written](const logger::log_message& msg, int) {
+                              written.push_back(msg.context);
+                          })
+            .unlock();
+        logger::instance().init_async_log(options);
+
+        static const int threads_count = 4;
+        static const int messages_count = 500;
+
+        std::vector<std::thread> threads;
+        for (int ci = 0; ci < threads_count; ++ci)
+        {
+            threads.emplace_back([]() {
+                const std::string huge(200000, 'h');
+                for (int cj = 0; cj < messages_count; ++cj)
+                {
+                    if (cj % 100 == 50)
+                        LOG_INFO(huge);
+                    else
+                        LOG_INFO(cj);
+                }
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+
+        logger::instance().flush();
+
+        BOOST_REQUIRE_EQUAL(written.size(), threads_count * messages_count);
+        for (size_t ci = 1; ci < written.size(); ++ci)
+        {
+            BOOST_REQUIRE(written[ci - 1].timestamp <= written[ci].timestamp);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(async_fatal_bypass_check)
+    {
+        print_current_test_name();
+
+        const auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).generic_string();
+
+        logger::file_options file_options;
+        file_options.flush_period = std::chrono::milliseconds(60000);
+
+        // Records would wait for reorder window and file flush period
+        logger::async_options options;
+        options.reorder_window = std::chrono::seconds(60);
+
+        logger::instance().init_file_log(path, file_options).set_details(logger::details_message_only).set_level(logger::level_trace).init_async_log(options).set_sync_errors();
+
+        auto read_file = [&path]() {
+            std::ifstream input(path);
+            return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        };
+
+        LOG_INFO("info 1");
+        LOG_DEBUG("debug 2");
+        LOG_FATAL("fatal 3");
+
+        // Written before LOG_FATAL returns, after previous records of the thread
+        auto text = read_file();
+        BOOST_REQUIRE_EQUAL(text, "info 1\ndebug 2\nfatal 3\n");
+
+        LOG_INFO("info 4");
+        LOG_ERROR("error 5");
+        text = read_file();
+        BOOST_REQUIRE_EQUAL(text, "info 1\ndebug 2\nfatal 3\ninfo 4\nerror 5\n");
+
+        // Not urgent
+        LOG_WARN("warning 6");
+        text = read_file();
+        BOOST_REQUIRE(text.find("warning 6") == std::string::npos);
+
+        logger::destroy();
+        text = read_file();
+        BOOST_REQUIRE(text.find("warning 6") != std::string::npos);
+        boost::filesystem::remove(path);
+    }
+
+    BOOST_AUTO_TEST_CASE(async_record_layout_check)
+    {
+        print_current_test_name();
+
+        // The smallest ring (4096 bytes)
+        logger::async_options options;
+        options.queue_capacity = 1;
+
+        logger::instance().init_cli_log().set_details(logger::details_message_only).set_level(logger::level_trace).init_async_log(options);
+
+        create_log_file(current_test_name());
+
+        const std::string huge(10000, 'h');
+        const std::string user = "user";
+        LOG_INFO_KV("before", kv("count", 3), kv("user", user), kv("ratio", 0.25), kv("ok", false));
+        // Doesn't fit ring
+        LOG_INFO(huge);
+        LOG_INFO("after " << ll::lazy([]() { return 42; }));
+
+        logger::instance().flush();
+
+        std::ifstream input(close_log_file());
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(input, line);)
+            lines.push_back(line);
+
+        BOOST_REQUIRE_EQUAL(lines.size(), 3);
+        BOOST_REQUIRE_EQUAL(lines[0], "before count=3 user=user ratio=0.25 ok=false");
+        BOOST_REQUIRE_EQUAL(lines[1], huge);
+        BOOST_REQUIRE_EQUAL(lines[2], "after 42");
+    }
+
+    BOOST_AUTO_TEST_CASE(async_thread_names_check)
+    {
+        print_current_test_name();
+
+        logger::async_options options;
+        options.flushers = 2;
+        options.numa_affinity = true;
+
+        std::mutex names_mutex;
+        std::set<std::string> names;
+        logger::instance().add_destination([&](const logger::log_message&, int) {
+            char buff[16];
+            BOOST_REQUIRE_EQUAL(pthread_getname_np(pthread_self(), buff, sizeof(buff)), 0);
+            std::lock_guard<std::mutex> lock(names_mutex);
+            names.emplace(buff);
+        });
+        logger::instance().unlock();
+        logger::instance().init_async_log(options);
+
+        for (int ci = 0; ci < 100; ++ci)
+        {
+            std::thread([ci]() { LOG_INFO(ci); }).join();
+        }
+        logger::instance().flush();
+
+        BOOST_REQUIRE(!names.empty());
+        for (const auto& name : names)
+        {
+            BOOST_REQUIRE(name == "ll-flusher-0" || name == "ll-flusher-1");
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(async_external_drain_check)
+    {
+        print_current_test_name();
+
+        logger::async_options options;
+        options.external_drain = true;
+        options.queue_capacity = 16;
+
+        std::set<std::thread::id> writers;
+        logger::instance().add_destination([&](const logger::log_message&, int) {
+            writers.insert(std::this_thread::get_id());
+        });
+        logger::instance().init_cli_log().set_details(logger::details_message_only).init_async_log(options);
+
+        const int fd = logger::instance().drain_fd();
+        BOOST_REQUIRE_GE(fd, 0);
+        auto readable = [fd]() {
+            pollfd item = { fd, POLLIN, 0 };
+            return poll(&item, 1, 0) == 1;
+        };
+
+        create_log_file(current_test_name());
+
+        BOOST_REQUIRE(!readable());
+        for (int ci = 0; ci < 10; ++ci)
+        {
+            LOG_INFO(0 << ' ' << ci);
+        }
+        BOOST_REQUIRE(readable());
+
+        // Signaled again while records remain
+        BOOST_REQUIRE_EQUAL(logger::instance().drain(3), 3);
+        BOOST_REQUIRE(readable());
+        BOOST_REQUIRE_EQUAL(logger::instance().drain(), 7);
+        BOOST_REQUIRE(!readable());
+        BOOST_REQUIRE_EQUAL(logger::instance().drain(), 0);
+
+        std::thread([]() {
+            for (int ci = 0; ci < 5; ++ci)
+            {
+                LOG_INFO(1 << ' ' << ci);
+            }
+        }).join();
+        BOOST_REQUIRE(readable());
+        BOOST_REQUIRE_GE(logger::instance().drain(std::numeric_limits<size_t>::max(), std::chrono::microseconds(1)), 1);
+        logger::instance().drain();
+        BOOST_REQUIRE(!readable());
+
+        // Full queue is written by producer instead of waiting for drain
+        for (int ci = 10; ci < 100; ++ci)
+        {
+            LOG_INFO(0 << ' ' << ci);
+        }
+        logger::instance().flush();
+        BOOST_REQUIRE_EQUAL(logger::instance().drain(), 0);
+
+        BOOST_REQUIRE_EQUAL(check_ordered_per_thread(close_log_file()), 105);
+        // No flusher threads
+        BOOST_REQUIRE_EQUAL(writers.size(), 1);
+        BOOST_REQUIRE(*writers.begin() == std::this_thread::get_id());
+    }
+
+    BOOST_AUTO_TEST_CASE(async_external_drain_concurrent_check)
+    {
+        print_current_test_name();
+
+        logger::async_options options;
+        options.external_drain = true;
+
+        logger::instance().init_cli_log().set_details(logger::details_message_only).init_async_log(options);
+
+        const int fd = logger::instance().drain_fd();
+        auto readable = [fd]() {
+            pollfd item = { fd, POLLIN, 0 };
+            return poll(&item, 1, 0) == 1;
+        };
+
+        create_log_file(current_test_name());
+
+        static const int messages_count = 20000;
+
+        // Pushes race with signal reset of drain
+        std::atomic_bool stop(false);
+        std::thread drainer([&stop]() {
+            while (!stop.load())
+                logger::instance().drain();
+        });
+        for (int ci = 0; ci < messages_count; ++ci)
+        {
+            LOG_INFO(0 << ' ' << ci);
+        }
+        stop = true;
+        drainer.join();
+        logger::instance().drain();
+
+        // Signal isn't lost by the last drain
+        BOOST_REQUIRE(!readable() || logger::instance().drain() == 0);
+        LOG_INFO(0 << ' ' << messages_count);
+        BOOST_REQUIRE(readable());
+        BOOST_REQUIRE_EQUAL(logger::instance().drain(), 1);
+
+        BOOST_REQUIRE_EQUAL(check_ordered_per_thread(close_log_file()), messages_count + 1);
+    }
+
+    BOOST_AUTO_TEST_CASE(parse_cpu_list_check)
+    {
+        print_current_test_name();
+
+        BOOST_REQUIRE(server_lib::parse_cpu_list("") == std::vector<int>());
+        BOOST_REQUIRE(server_lib::parse_cpu_list("3") == std::vector<int>({ 3 }));
+        BOOST_REQUIRE(server_lib::parse_cpu_list("0-3,8,10-11\n") == std::vector<int>({ 0, 1, 2, 3, 8, 10, 11 }));
+
+        const auto& topology = server_lib::numa_topology::instance();
+        BOOST_REQUIRE_GE(topology.nodes_count(), 1);
+        BOOST_REQUIRE_LT(topology.current_node(), topology.nodes_count());
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
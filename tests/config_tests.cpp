@@ -0,0 +1,195 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include <logger/platform_config.h>
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <csignal>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        class config_file
+        {
+        public:
+            config_file()
+            {
+                _path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+                _path += ".conf";
+            }
+
+            ~config_file()
+            {
+                boost::filesystem::remove(_path);
+            }
+
+            void write(const std::string& content)
+            {
+                std::ofstream(_path.generic_string().c_str()) << content;
+            }
+
+            std::string path() const
+            {
+                return _path.generic_string();
+            }
+
+        private:
+            boost::filesystem::path _path;
+        };
+
+        bool wait_epoch_changed(uint32_t epoch)
+        {
+            for (int ci = 0; ci < 200; ++ci)
+            {
+                if (logger::instance().config_epoch() != epoch)
+                    return true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return false;
+        }
+    } // namespace
+
+    BOOST_FIXTURE_TEST_SUITE(config_tests, logger_cleanup)
+
+    BOOST_AUTO_TEST_CASE(load_config_check)
+    {
+        print_current_test_name();
+
+        config_file config;
+        config.write("# test\n"
+                     "level = warning\n"
+                     "details=55\n"
+                     "destination.0.level=error\n"
+                     "destination.7.level=error\n"
+                     "unknown=1\n");
+
+        logger::instance().init_cli_log();
+
+        auto epoch = logger::instance().config_epoch();
+        logger::instance().load_config(config.path());
+
+        BOOST_REQUIRE_EQUAL(logger::instance().level_filter(), logger::level_warning);
+        BOOST_REQUIRE_EQUAL(logger::instance().details_filter(), logger::details_message_with_level);
+        BOOST_REQUIRE_EQUAL(logger::instance().destination_level_filter(0), logger::level_error);
+        BOOST_REQUIRE(logger::instance().config_epoch() != epoch);
+    }
+
+    BOOST_AUTO_TEST_CASE(reload_config_check)
+    {
+        print_current_test_name();
+
+        config_file config;
+        config.write("level=info\n"
+                     "destination.0.level=error\n");
+
+        logger::instance().init_cli_log();
+        logger::instance().add_destination([](const logger::log_message&, int) {});
+        logger::instance().set_destination_level(1, logger::level_warning);
+
+        // Published by single state
+        auto epoch = logger::instance().config_epoch();
+        logger::instance().load_config(config.path());
+        BOOST_REQUIRE_EQUAL(logger::instance().config_epoch(), epoch + 1);
+        BOOST_REQUIRE_EQUAL(logger::instance().level_filter(), logger::level_info);
+        BOOST_REQUIRE_EQUAL(logger::instance().destination_level_filter(0), logger::level_error);
+
+        // Level of removed key is reset, one set by code is kept
+        config.write("level=debug\n");
+        logger::instance().load_config(config.path());
+        BOOST_REQUIRE_EQUAL(logger::instance().level_filter(), logger::level_debug);
+        BOOST_REQUIRE_EQUAL(logger::instance().destination_level_filter(0), logger::level_trace);
+        BOOST_REQUIRE_EQUAL(logger::instance().destination_level_filter(1), logger::level_warning);
+    }
+
+    BOOST_AUTO_TEST_CASE(config_update_concurrent_check)
+    {
+        print_current_test_name();
+
+        // Destination reads filters while states are replaced (and freed).
+        // It sees the state the record has passed
+        std::atomic<size_t> mismatches(0);
+        logger::instance().add_destination([&mismatches](const logger::log_message&, int) {
+                              if (logger::instance().level_filter() & static_cast<int>(logger::level::info))
+                                  ++mismatches;
+                          })
+            .set_level(logger::level_info)
+            .unlock();
+
+        std::atomic_bool stop(false);
+        std::atomic<size_t> records(0);
+        std::thread writer([&stop, &records]() {
+            while (!stop || !records)
+            {
+                LOG_INFO("record");
+                ++records;
+            }
+        });
+
+        for (int ci = 0; ci < 2000; ++ci)
+        {
+            logger::instance().set_level((ci % 2) ? logger::level_info : logger::level_warning);
+        }
+        stop = true;
+        writer.join();
+        BOOST_REQUIRE_EQUAL(mismatches, 0);
+
+        const auto epoch = logger::instance().config_epoch();
+        logger::instance().set_level(logger::level_info);
+        BOOST_REQUIRE_EQUAL(logger::instance().config_epoch(), epoch + 1);
+        BOOST_REQUIRE_EQUAL(logger::instance().level_filter(), logger::level_info);
+    }
+
+    BOOST_AUTO_TEST_CASE(destination_level_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_details(logger::details_message_only).set_destination_level(0, logger::level_error);
+
+        create_log_file(current_test_name());
+
+        LOG_INFO("info");
+        LOG_WARN("warning");
+        LOG_ERROR("error");
+
+        std::ifstream input(close_log_file());
+        std::string line;
+        std::getline(input, line);
+        BOOST_REQUIRE_EQUAL(line, "error");
+        BOOST_REQUIRE(!std::getline(input, line));
+    }
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    BOOST_AUTO_TEST_CASE(watch_config_check)
+    {
+        print_current_test_name();
+
+        config_file config;
+        config.write("level=debug\n");
+
+        logger::instance().init_cli_log().watch_config(config.path(), SIGUSR1);
+
+        BOOST_REQUIRE_EQUAL(logger::instance().level_filter(), logger::level_debug);
+
+        // Rewritten file
+        auto epoch = logger::instance().config_epoch();
+        config.write("level=error\n");
+        BOOST_REQUIRE(wait_epoch_changed(epoch));
+        BOOST_REQUIRE_EQUAL(logger::instance().level_filter(), logger::level_error);
+
+        // Signal
+        epoch = logger::instance().config_epoch();
+        std::raise(SIGUSR1);
+        BOOST_REQUIRE(wait_epoch_changed(epoch));
+        BOOST_REQUIRE_EQUAL(logger::instance().level_filter(), logger::level_error);
+    }
+#endif
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
@@ -0,0 +1,126 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        std::vector<std::string> read_lines(const std::string& path)
+        {
+            std::ifstream input(path);
+            std::vector<std::string> lines;
+            for (std::string line; std::getline(input, line);)
+                lines.push_back(line);
+            return lines;
+        }
+    } // namespace
+
+    BOOST_FIXTURE_TEST_SUITE(context_tests, logger_cleanup)
+
+    BOOST_AUTO_TEST_CASE(context_guard_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_trace).set_details(logger::details_message_only);
+
+        create_log_file(current_test_name());
+
+        LOG_INFO("before");
+        {
+            ll::context_guard request("req", 42);
+            LOG_INFO("started");
+            {
+                ll::context_guard user("user", std::string("bob"));
+                LOG_INFO_KV("authorized", kv("ok", true));
+            }
+            LOG_INFO("done");
+        }
+        LOG_INFO("after");
+
+        auto lines = read_lines(close_log_file());
+        std::vector<std::string> expected = {
+            "before",
+            "[req=42] started",
+            "[req=42 user=bob] authorized ok=true",
+            "[req=42] done",
+            "after",
+        };
+        BOOST_REQUIRE_EQUAL(lines.size(), expected.size());
+        for (size_t ci = 0; ci < lines.size(); ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(lines[ci], expected[ci]);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(context_guard_async_check)
+    {
+        print_current_test_name();
+
+        logger::async_options options;
+        // Records are written after guards are gone
+        options.reorder_window = std::chrono::seconds(60);
+
+        logger::instance().init_cli_log().set_level(logger::level_trace).set_details(logger::details_message_only).init_async_log(options);
+
+        create_log_file(current_test_name());
+
+        std::thread([]() {
+            ll::context_guard worker("worker", "w1");
+            for (int ci = 0; ci < 3; ++ci)
+            {
+                ll::context_guard job("job", ci);
+                LOG_INFO("handled");
+            }
+        }).join();
+
+        logger::instance().flush();
+
+        auto lines = read_lines(close_log_file());
+        BOOST_REQUIRE_EQUAL(lines.size(), 3);
+        for (int ci = 0; ci < 3; ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(lines[ci], "[worker=w1 job=" + std::to_string(ci) + "] handled");
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(context_guard_json_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_json_log().set_level(logger::level_trace).set_details(logger::details_message_only);
+
+        create_log_file(current_test_name());
+
+        {
+            ll::context_guard request("req", 7u);
+            ll::context_guard user("user", "\"bob\"");
+            LOG_INFO_KV("done", kv("ok", true));
+        }
+
+        auto lines = read_lines(close_log_file());
+        BOOST_REQUIRE_EQUAL(lines.size(), 1);
+
+        namespace pt = boost::property_tree;
+        pt::ptree record;
+        std::istringstream ss(lines[0]);
+        pt::read_json(ss, record);
+
+        BOOST_REQUIRE_EQUAL(record.get<std::string>("message"), "done");
+        BOOST_REQUIRE_EQUAL(record.get<int>("req"), 7);
+        BOOST_REQUIRE_EQUAL(record.get<std::string>("user"), "\"bob\"");
+        BOOST_REQUIRE_EQUAL(record.get<bool>("ok"), true);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
@@ -0,0 +1,194 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include "json_writer.h"
+#include "text_escape.h"
+#include "text_writer.h"
+
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        using server_lib::escape_isa;
+
+        std::vector<escape_isa> supported_isas()
+        {
+            std::vector<escape_isa> result;
+            for (auto isa : { escape_isa::scalar, escape_isa::sse2, escape_isa::avx2 })
+            {
+                if (server_lib::set_escape_isa(isa))
+                    result.push_back(isa);
+            }
+            return result;
+        }
+
+        // Byte by byte reference
+        std::string sanitized_reference(const std::string& text)
+        {
+            static const char hex_digits[] = "0123456789abcdef";
+            std::string result;
+            for (unsigned char ch : text)
+            {
+                if (ch == '\n')
+                    result += "\\n";
+                else if (ch == '\r')
+                    result += "\\r";
+                else if (ch == '\\')
+                    result += "\\\\";
+                else if ((ch < 0x20 && ch != '\t') || ch == 0x7F)
+                {
+                    result += "\\x";
+                    result.push_back(hex_digits[ch >> 4]);
+                    result.push_back(hex_digits[ch & 0xF]);
+                }
+                else
+                    result.push_back(static_cast<char>(ch));
+            }
+            return result;
+        }
+
+        std::vector<std::string> read_lines(const std::string& path)
+        {
+            std::ifstream input(path);
+            std::vector<std::string> lines;
+            for (std::string line; std::getline(input, line);)
+                lines.push_back(line);
+            return lines;
+        }
+
+        // The best implementation is restored after test
+        struct escape_cleanup : public logger_cleanup
+        {
+            escape_cleanup()
+                : _isa(server_lib::current_escape_isa())
+            {
+            }
+
+            ~escape_cleanup()
+            {
+                server_lib::set_escape_isa(_isa);
+            }
+
+        private:
+            escape_isa _isa;
+        };
+    } // namespace
+
+    BOOST_FIXTURE_TEST_SUITE(escape_tests, escape_cleanup)
+
+    BOOST_AUTO_TEST_CASE(escape_finders_check)
+    {
+        print_current_test_name();
+
+        const auto isas = supported_isas();
+        BOOST_REQUIRE(!isas.empty());
+
+        // Every special byte at every position of spans crossing vector width
+        const std::string json_special = std::string("\"\\\x01\x1f\n", 5) + std::string(1, '\0');
+        const std::string control = std::string("\n\r\x01\x1f\x7f\\", 6) + std::string(1, '\0');
+        for (auto isa : isas)
+        {
+            BOOST_REQUIRE(server_lib::set_escape_isa(isa));
+            for (size_t size = 0; size < 80; ++size)
+            {
+                // Bytes are never special for both finders
+                std::string text(size, 'a');
+                text.append(std::string("\t\xff\x80 ~", 5));
+                const char* end = text.data() + text.size();
+                BOOST_REQUIRE(server_lib::find_control(text.data(), end) == end);
+                BOOST_REQUIRE(server_lib::find_json_special(text.data(), text.data() + size) == text.data() + size);
+
+                for (size_t pos = 0; pos < size; ++pos)
+                {
+                    for (char ch : json_special)
+                    {
+                        std::string current(size, 'a');
+                        current[pos] = ch;
+                        BOOST_REQUIRE(server_lib::find_json_special(current.data(), current.data() + size) == current.data() + pos);
+                    }
+                    for (char ch : control)
+                    {
+                        std::string current(size, 'a');
+                        current[pos] = ch;
+                        BOOST_REQUIRE(server_lib::find_control(current.data(), current.data() + size) == current.data() + pos);
+                    }
+                }
+            }
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(escape_random_check)
+    {
+        print_current_test_name();
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> byte(0, 255);
+        std::uniform_int_distribution<int> sparse(0, 40);
+
+        for (int ci = 0; ci < 200; ++ci)
+        {
+            std::string text(static_cast<size_t>(ci * 3), '\0');
+            for (auto& ch : text)
+                ch = static_cast<char>(sparse(rng) ? 'a' + sparse(rng) % 26 : byte(rng));
+
+            const auto expected = sanitized_reference(text);
+            std::string expected_json;
+            for (auto isa : supported_isas())
+            {
+                BOOST_REQUIRE(server_lib::set_escape_isa(isa));
+
+                std::string sanitized;
+                server_lib::append_sanitized(sanitized, text.data(), text.size());
+                BOOST_REQUIRE_EQUAL(sanitized, expected);
+
+                std::string json;
+                server_lib::append_json_escaped(json, text.data(), text.size());
+                if (isa == escape_isa::scalar)
+                    expected_json = json;
+                BOOST_REQUIRE_EQUAL(json, expected_json);
+            }
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(escape_sinks_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_trace).set_details(logger::details_message_only);
+
+        create_log_file(current_test_name());
+
+        LOG_INFO("multi\nline");
+        logger::instance().set_sanitize_text();
+        LOG_INFO_KV("multi\nline\r", kv("user", std::string("a\x01\tb")), kv("path", std::string("c:\\n")));
+        logger::instance().set_sanitize_text(false);
+        LOG_INFO("raw\x7f");
+
+        auto lines = read_lines(close_log_file());
+        std::vector<std::string> expected = {
+            "multi",
+            "line",
+            "multi\\nline\\r user=a\\x01\tb path=c:\\\\n",
+            "raw\x7f",
+        };
+        BOOST_REQUIRE_EQUAL(lines.size(), expected.size());
+        for (size_t ci = 0; ci < lines.size(); ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(lines[ci], expected[ci]);
+        }
+
+        logger::log_message msg;
+        msg << "first\nsecond";
+        BOOST_REQUIRE_EQUAL(server_lib::render_syslog_text(msg, logger::details_message_only), "first\\nsecond");
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
@@ -0,0 +1,423 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include "lz_block.h"
+#include "log_index.h"
+#include "line_scanner.h"
+#include "file_writer.h"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <map>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        std::string read_file(const std::string& path)
+        {
+            std::ifstream input(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        }
+
+        std::string temp_path(const std::string& suffix)
+        {
+            auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+            return path.generic_string() + '.' + suffix;
+        }
+    } // namespace
+
+    BOOST_AUTO_TEST_SUITE(file_tests)
+
+    BOOST_AUTO_TEST_CASE(lz_round_trip_check)
+    {
+        print_current_test_name();
+
+        std::mt19937 rng(42);
+        std::string noise(10000, '\0');
+        for (auto& ch : noise)
+            ch = static_cast<char>(rng());
+
+        std::string rows;
+        for (int ci = 0; ci < 500; ++ci)
+            rows += "2024-01-01T00:00:00.000001     [debug] request " + std::to_string(ci) + " done (from main.cpp:42)\n";
+
+        for (const auto& data : { std::string(), std::string("abc"), std::string(1000, 'x'), noise, rows })
+        {
+            std::vector<char> compressed(server_lib::lz_compress_bound(data.size()));
+            auto size = server_lib::lz_compress(data.data(), data.size(), compressed.data(), compressed.size());
+
+            std::string restored(data.size(), '\0');
+            BOOST_REQUIRE(server_lib::lz_decompress(compressed.data(), size, &restored[0], restored.size()));
+            BOOST_REQUIRE(restored == data);
+        }
+
+        std::vector<char> compressed(server_lib::lz_compress_bound(rows.size()));
+        auto size = server_lib::lz_compress(rows.data(), rows.size(), compressed.data(), compressed.size());
+        BOOST_REQUIRE_LT(size * 5, rows.size());
+    }
+
+    BOOST_AUTO_TEST_CASE(lz_frames_recovery_check)
+    {
+        print_current_test_name();
+
+        const std::string first(3000, 'a');
+        const std::string second = "second block\n";
+        const std::string third = "third block\n";
+
+        std::string stream;
+        server_lib::append_lz_frame(stream, first.data(), first.size());
+        const auto first_end = stream.size();
+        server_lib::append_lz_frame(stream, second.data(), second.size());
+        // Torn frame (crash)
+        stream.resize(stream.size() - 3);
+        stream += "garbage";
+        server_lib::append_lz_frame(stream, third.data(), third.size());
+
+        std::string out;
+        auto skipped = server_lib::decode_lz_frames(stream.data(), stream.size(), out);
+        BOOST_REQUIRE(skipped > 0);
+        BOOST_REQUIRE_EQUAL(out, first + third);
+
+        // Tail reading from the middle of the stream
+        out.clear();
+        server_lib::decode_lz_frames(stream.data() + first_end / 2, stream.size() - first_end / 2, out);
+        BOOST_REQUIRE_EQUAL(out, third);
+    }
+
+    BOOST_AUTO_TEST_CASE(find_log_blocks_check)
+    {
+        print_current_test_name();
+
+        // Neighbour blocks overlap (records of different threads)
+        std::vector<server_lib::log_index_entry> entries = {
+            { 100, 200, 0, 10 },
+            { 150, 300, 10, 10 },
+            { 290, 400, 20, 10 },
+            { 400, 500, 30, 10 },
+            { 600, 700, 40, 10 },
+        };
+        server_lib::log_index_bounds bounds;
+        server_lib::make_log_index_bounds(entries, bounds);
+
+        auto range = server_lib::find_log_blocks(bounds, 250, 420);
+        BOOST_REQUIRE_EQUAL(range.first, 1);
+        BOOST_REQUIRE_EQUAL(range.second, 4);
+
+        range = server_lib::find_log_blocks(bounds, 0, 50);
+        BOOST_REQUIRE_EQUAL(range.first, range.second);
+
+        range = server_lib::find_log_blocks(bounds, 550, 1000);
+        BOOST_REQUIRE_EQUAL(range.first, 4);
+        BOOST_REQUIRE_EQUAL(range.second, 5);
+    }
+
+    BOOST_AUTO_TEST_CASE(line_scanner_check)
+    {
+        print_current_test_name();
+
+        const std::string text = "short\n\na line longer than sixteen bytes to scan by chunks\nlast";
+
+        std::vector<std::string> lines;
+        server_lib::for_each_line(text.data(), text.size(), [&](const char* line, size_t size) {
+            lines.emplace_back(line, size);
+        });
+
+        BOOST_REQUIRE_EQUAL(lines.size(), 4);
+        BOOST_REQUIRE_EQUAL(lines[0], "short");
+        BOOST_REQUIRE_EQUAL(lines[1], "");
+        BOOST_REQUIRE_EQUAL(lines[2], "a line longer than sixteen bytes to scan by chunks");
+        BOOST_REQUIRE_EQUAL(lines[3], "last");
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+    BOOST_FIXTURE_TEST_SUITE(file_sink_tests, logger_cleanup)
+
+    BOOST_AUTO_TEST_CASE(file_raw_check)
+    {
+        print_current_test_name();
+
+        const auto path = temp_path("log");
+
+        logger::instance().init_file_log(path).set_level(logger::level_trace).set_details(logger::details_message_only);
+
+        LOG_INFO("first");
+        LOG_DEBUG("second " << 2);
+        logger::instance().flush();
+
+        BOOST_REQUIRE_EQUAL(read_file(path), "first\nsecond 2\n");
+
+        logger::destroy();
+        boost::filesystem::remove(path);
+    }
+
+    BOOST_AUTO_TEST_CASE(file_compressed_rotation_check)
+    {
+        print_current_test_name();
+
+        const auto path = temp_path("llz");
+
+        logger::file_options options;
+        options.compress = true;
+        options.block_size = 4096;
+        options.rotation_size = 2048;
+        options.max_files = 100;
+
+        logger::instance().init_file_log(path, options).init_async_log().set_level(logger::level_trace).set_details(logger::details_message_only);
+
+        std::string expected;
+        const int records = 5000;
+        for (int ci = 0; ci < records; ++ci)
+        {
+            LOG_INFO("record " << ci << " of compressed file");
+            expected += "record " + std::to_string(ci) + " of compressed file\n";
+        }
+        logger::destroy();
+
+        BOOST_REQUIRE(boost::filesystem::exists(path + ".1"));
+        BOOST_REQUIRE(!boost::filesystem::exists(path + ".100"));
+
+        // Every segment is decodable independently
+        std::string restored;
+        size_t segments = 0;
+        for (size_t ci = 100; ci > 0; --ci)
+        {
+            auto segment = path + '.' + std::to_string(ci);
+            if (!boost::filesystem::exists(segment))
+                continue;
+            auto data = read_file(segment);
+            BOOST_REQUIRE_EQUAL(server_lib::decode_lz_frames(data.data(), data.size(), restored), 0);
+            boost::filesystem::remove(segment);
+            ++segments;
+        }
+        auto data = read_file(path);
+        BOOST_REQUIRE_EQUAL(server_lib::decode_lz_frames(data.data(), data.size(), restored), 0);
+        boost::filesystem::remove(path);
+
+        BOOST_REQUIRE(segments > 1);
+        BOOST_REQUIRE_EQUAL(restored.size(), expected.size());
+        BOOST_REQUIRE(restored == expected);
+    }
+
+    BOOST_AUTO_TEST_CASE(file_index_check)
+    {
+        print_current_test_name();
+
+        const auto path = temp_path("llz");
+
+        logger::file_options options;
+        options.compress = true;
+        options.block_size = 1024;
+        options.write_index = true;
+
+        logger::instance().init_file_log(path, options).set_level(logger::level_trace).set_details(logger::details_message_only);
+
+        const auto start_us = std::chrono::duration_cast<std::chrono::microseconds>(logger::clock_type::now().time_since_epoch()).count();
+        for (int ci = 0; ci < 1000; ++ci)
+        {
+            LOG_INFO("indexed record " << ci);
+        }
+        logger::destroy();
+        const auto end_us = std::chrono::duration_cast<std::chrono::microseconds>(logger::clock_type::now().time_since_epoch()).count();
+
+        const auto data = read_file(path);
+        const auto index = read_file(server_lib::log_index_path(path));
+        boost::filesystem::remove(path);
+        boost::filesystem::remove(server_lib::log_index_path(path));
+
+        std::vector<server_lib::log_index_entry> entries;
+        BOOST_REQUIRE(server_lib::read_log_index(index.data(), index.size(), entries));
+        BOOST_REQUIRE(entries.size() > 1);
+
+        uint64_t offset = 0;
+        std::string restored;
+        for (const auto& entry : entries)
+        {
+            BOOST_REQUIRE_EQUAL(entry.offset, offset);
+            BOOST_REQUIRE(entry.min_time_us <= entry.max_time_us);
+            BOOST_REQUIRE(entry.min_time_us >= start_us - 1000);
+            BOOST_REQUIRE(entry.max_time_us <= end_us + 1000);
+            // Every block is decodable by itself
+            BOOST_REQUIRE_EQUAL(server_lib::decode_lz_frames(data.data() + entry.offset, entry.size, restored), 0);
+            offset += entry.size;
+        }
+        BOOST_REQUIRE_EQUAL(offset, data.size());
+        BOOST_REQUIRE(restored.find("indexed record 999\n") != std::string::npos);
+    }
+
+    BOOST_AUTO_TEST_CASE(file_shared_processes_check)
+    {
+        print_current_test_name();
+
+        const auto path = temp_path("log");
+
+        logger::file_options options;
+        options.shared = true;
+        options.block_size = 1024;
+        options.rotation_size = 16 << 10;
+        options.max_files = 100;
+
+        // Rows are "[pid:thread]record N" (or "[pid]" for main thread)
+        const int details = logger::details_message_only - static_cast<int>(logger::details::without_thread_info);
+        const int processes = 3;
+        const int records = 2000;
+
+        std::vector<pid_t> children;
+        for (int ci = 0; ci < processes; ++ci)
+        {
+            auto pid = fork();
+            BOOST_REQUIRE(pid >= 0);
+            if (pid == 0)
+            {
+                int code = 0;
+                try
+                {
+                    if (logger::log_context().pid != static_cast<int>(getpid()))
+                        code = 2;
+                    logger::instance().init_file_log(path, options).set_level(logger::level_trace).set_details(details);
+                    for (int cj = 0; cj < records; ++cj)
+                    {
+                        LOG_INFO("record " << cj);
+                    }
+                    logger::destroy();
+                }
+                catch (...)
+                {
+                    code = 1;
+                }
+                _exit(code);
+            }
+            children.push_back(pid);
+        }
+        for (auto pid : children)
+        {
+            int status = 0;
+            BOOST_REQUIRE_EQUAL(waitpid(pid, &status, 0), pid);
+            BOOST_REQUIRE(WIFEXITED(status));
+            BOOST_REQUIRE_EQUAL(WEXITSTATUS(status), 0);
+        }
+
+        // From the oldest segment. Records of every process are whole and ordered
+        std::map<int, int> next_records;
+        size_t segments = 0;
+        auto check_segment = [&](const std::string& segment) {
+            std::ifstream input(segment);
+            for (std::string line; std::getline(input, line);)
+            {
+                int pid = 0, record = -1;
+                char tail = 0;
+                auto end = line.find(']');
+                BOOST_REQUIRE(end != std::string::npos);
+                BOOST_REQUIRE_EQUAL(std::sscanf(line.c_str(), "[%d%c", &pid, &tail), 2);
+                BOOST_REQUIRE_EQUAL(std::sscanf(line.c_str() + end + 1, "record %d", &record), 1);
+                BOOST_REQUIRE_EQUAL(line.substr(end + 1), "record " + std::to_string(record));
+
+                auto& next = next_records[pid];
+                BOOST_REQUIRE_EQUAL(record, next);
+                ++next;
+            }
+            boost::filesystem::remove(segment);
+        };
+        for (size_t ci = 100; ci > 0; --ci)
+        {
+            auto segment = path + '.' + std::to_string(ci);
+            if (!boost::filesystem::exists(segment))
+                continue;
+            check_segment(segment);
+            ++segments;
+        }
+        check_segment(path);
+        boost::filesystem::remove(path + ".lock");
+
+        BOOST_REQUIRE(segments > 1);
+        BOOST_REQUIRE_EQUAL(next_records.size(), static_cast<size_t>(processes));
+        for (const auto& item : next_records)
+        {
+            BOOST_REQUIRE_EQUAL(item.second, records);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(file_io_uring_check)
+    {
+        print_current_test_name();
+
+        for (int variant = 0; variant < 4; ++variant)
+        {
+            const auto path = temp_path("log");
+
+            logger::file_options options;
+            options.use_io_uring = true;
+            options.sqpoll = (variant & 1) != 0;
+            options.compress = (variant & 2) != 0;
+            options.block_size = 1024;
+            options.rotation_size = 8 << 10;
+            options.max_files = 100;
+            options.write_index = true;
+
+            std::string expected;
+            {
+                server_lib::file_writer writer(path, options);
+                if (!writer.uses_io_uring())
+                    BOOST_TEST_MESSAGE("io_uring is unavailable, writev is checked");
+
+                for (int ci = 0; ci < 3000; ++ci)
+                {
+                    auto row = "record " + std::to_string(ci) + " of variant " + std::to_string(variant) + '\n';
+                    writer.write(row.data(), row.size(), ci);
+                    expected += row;
+                }
+                // Completed writes only
+                writer.flush(true);
+            }
+
+            std::string restored;
+            size_t segments = 0;
+            auto read_segment = [&](const std::string& segment) {
+                auto data = read_file(segment);
+                auto index = read_file(server_lib::log_index_path(segment));
+                std::vector<server_lib::log_index_entry> entries;
+                BOOST_REQUIRE(server_lib::read_log_index(index.data(), index.size(), entries));
+                uint64_t offset = 0;
+                for (const auto& entry : entries)
+                {
+                    BOOST_REQUIRE_EQUAL(entry.offset, offset);
+                    offset += entry.size;
+                }
+                BOOST_REQUIRE_EQUAL(offset, data.size());
+
+                if (options.compress)
+                    BOOST_REQUIRE_EQUAL(server_lib::decode_lz_frames(data.data(), data.size(), restored), 0);
+                else
+                    restored += data;
+                boost::filesystem::remove(segment);
+                boost::filesystem::remove(server_lib::log_index_path(segment));
+            };
+            for (size_t ci = 100; ci > 0; --ci)
+            {
+                auto segment = path + '.' + std::to_string(ci);
+                if (!boost::filesystem::exists(segment))
+                    continue;
+                read_segment(segment);
+                ++segments;
+            }
+            read_segment(path);
+
+            BOOST_REQUIRE(segments > 1);
+            BOOST_REQUIRE_EQUAL(restored.size(), expected.size());
+            BOOST_REQUIRE(restored == expected);
+        }
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
@@ -0,0 +1,129 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        const char packet[] = "Hello, world!\n\0\xff\x01\x02";
+        const size_t packet_size = sizeof(packet) - 1;
+
+        std::string dump(const void* data, size_t size, const hexdump_options& options = hexdump_options())
+        {
+            std::ostringstream out;
+            out << hexdump(data, size, options);
+            return out.str();
+        }
+
+        std::vector<std::string> read_lines(const std::string& path)
+        {
+            std::ifstream input(path);
+            std::vector<std::string> lines;
+            for (std::string line; std::getline(input, line);)
+                lines.push_back(line);
+            return lines;
+        }
+    } // namespace
+
+    BOOST_FIXTURE_TEST_SUITE(hexdump_tests, logger_cleanup)
+
+    BOOST_AUTO_TEST_CASE(hexdump_layout_check)
+    {
+        print_current_test_name();
+
+        BOOST_REQUIRE_EQUAL(dump(packet, packet_size),
+                            "\n00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 21 0a 00 ff  |Hello, world!...|"
+                            "\n00000010  01 02                                             |..|");
+
+        hexdump_options options;
+        options.ascii = false;
+        BOOST_REQUIRE_EQUAL(dump(packet, packet_size, options),
+                            "\n00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 21 0a 00 ff"
+                            "\n00000010  01 02");
+
+        options.offsets = false;
+        options.width = 8;
+        BOOST_REQUIRE_EQUAL(dump(packet, 10, options),
+                            "\n48 65 6c 6c 6f 2c 20 77"
+                            "\n6f 72");
+
+        options.compact = true;
+        BOOST_REQUIRE_EQUAL(dump(packet, packet_size, options), "48656c6c6f2c20776f726c64210a00ff0102");
+
+        BOOST_REQUIRE(dump(packet, 0).empty());
+
+        options.width = 0;
+        BOOST_REQUIRE_THROW(dump(packet, packet_size, options), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(hexdump_truncation_check)
+    {
+        print_current_test_name();
+
+        // Larger than stack buffer of formatter
+        std::vector<unsigned char> data(100000);
+        for (size_t ci = 0; ci < data.size(); ++ci)
+            data[ci] = static_cast<unsigned char>(ci);
+
+        hexdump_options options;
+        options.max_bytes = 0;
+        const auto full = dump(data.data(), data.size(), options);
+        std::istringstream input(full);
+        std::string line;
+        std::getline(input, line);
+        BOOST_REQUIRE(line.empty());
+        size_t rows = 0;
+        for (; std::getline(input, line); ++rows)
+        {
+            BOOST_REQUIRE_EQUAL(line.size(), 78u);
+        }
+        BOOST_REQUIRE_EQUAL(rows, data.size() / 16);
+        BOOST_REQUIRE_EQUAL(full.find("\n000186a0"), std::string::npos);
+        BOOST_REQUIRE_NE(full.find("\n00018690  90 91 92 93 94 95 96 97  98 99 9a 9b 9c 9d 9e 9f  |................|"), std::string::npos);
+
+        options.max_bytes = 20;
+        BOOST_REQUIRE_EQUAL(dump(data.data(), data.size(), options),
+                            "\n00000000  00 01 02 03 04 05 06 07  08 09 0a 0b 0c 0d 0e 0f  |................|"
+                            "\n00000010  10 11 12 13                                       |....|"
+                            "\n... 99980 more bytes");
+
+        options.compact = true;
+        options.max_bytes = 4;
+        BOOST_REQUIRE_EQUAL(dump(data.data(), data.size(), options), "00010203 ... 99996 more bytes");
+    }
+
+    BOOST_AUTO_TEST_CASE(hexdump_message_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_trace).set_details(logger::details_message_only);
+
+        create_log_file(current_test_name());
+
+        hexdump_options options;
+        options.max_bytes = 16;
+        LOG_TRACE("packet " << packet_size << hexdump(packet, packet_size, options));
+
+        auto lines = read_lines(close_log_file());
+        std::vector<std::string> expected = {
+            "packet 18",
+            "00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 21 0a 00 ff  |Hello, world!...|",
+            "... 2 more bytes",
+        };
+        BOOST_REQUIRE_EQUAL(lines.size(), expected.size());
+        for (size_t ci = 0; ci < lines.size(); ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(lines[ci], expected[ci]);
+        }
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
@@ -0,0 +1,164 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "format_helper.h"
+#include "json_writer.h"
+
+#include <clocale>
+#include <cstring>
+#include <fstream>
+#include <locale>
+#include <sstream>
+#include <string>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        // Numeric locale is restored after test
+        struct numeric_locale_cleanup : public logger_cleanup
+        {
+            numeric_locale_cleanup()
+                : _locale(setlocale(LC_NUMERIC, nullptr))
+            {
+            }
+
+            ~numeric_locale_cleanup()
+            {
+                setlocale(LC_NUMERIC, _locale.c_str());
+            }
+
+        private:
+            std::string _locale;
+        };
+
+        void check_doubles_round_trip()
+        {
+            for (double value : { 0.5, 0.1, 1.0 / 3, -2.5e-7, 123456.789, 1e20, -1.7976931348623157e308, 4.9e-324 })
+            {
+                std::string text;
+                BOOST_REQUIRE(server_lib::format_helper::append_double(text, value));
+                BOOST_REQUIRE_EQUAL(text.find(','), std::string::npos);
+
+                std::istringstream input(text);
+                input.imbue(std::locale::classic());
+                double parsed = 0;
+                input >> parsed;
+                BOOST_REQUIRE(!input.fail());
+                BOOST_REQUIRE_EQUAL(parsed, value);
+            }
+        }
+    } // namespace
+
+    BOOST_FIXTURE_TEST_SUITE(json_tests, logger_cleanup)
+
+    BOOST_AUTO_TEST_CASE(json_fields_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_json_log().set_level(logger::level_trace).set_details(logger::details_without_app_name);
+
+        create_log_file(current_test_name());
+
+        const std::string user = "user \"1\"\n";
+        LOG_INFO_KV("request done", kv("latency_us", 125u), kv("user", user), kv("ratio", 0.5), kv("ok", true), kv("delta", -3));
+        LOG_DEBUG("plain " << 1);
+
+        std::ifstream input(close_log_file());
+
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(input, line);)
+            lines.push_back(line);
+
+        BOOST_REQUIRE_EQUAL(lines.size(), 2);
+
+        namespace pt = boost::property_tree;
+        {
+            pt::ptree record;
+            std::istringstream ss(lines[0]);
+            pt::read_json(ss, record);
+
+            BOOST_REQUIRE_EQUAL(record.get<std::string>("level"), "info");
+            BOOST_REQUIRE_EQUAL(record.get<std::string>("message"), "request done");
+            BOOST_REQUIRE_EQUAL(record.get<int>("latency_us"), 125);
+            BOOST_REQUIRE_EQUAL(record.get<std::string>("user"), user);
+            BOOST_REQUIRE_EQUAL(record.get<double>("ratio"), 0.5);
+            BOOST_REQUIRE_EQUAL(record.get<bool>("ok"), true);
+            BOOST_REQUIRE_EQUAL(record.get<int>("delta"), -3);
+            BOOST_REQUIRE(record.get<std::string>("file").find("json_tests.cpp") != std::string::npos);
+            BOOST_REQUIRE(record.get<int>("line") > 0);
+            BOOST_REQUIRE(record.get<uint64_t>("ts_us") > 0);
+            BOOST_REQUIRE(!record.get_optional<std::string>("app"));
+        }
+        {
+            pt::ptree record;
+            std::istringstream ss(lines[1]);
+            pt::read_json(ss, record);
+
+            BOOST_REQUIRE_EQUAL(record.get<std::string>("level"), "debug");
+            BOOST_REQUIRE_EQUAL(record.get<std::string>("message"), "plain 1");
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(text_fields_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_details(logger::details_message_only);
+
+        create_log_file(current_test_name());
+
+        LOG_WARN_KV("done", kv("code", 42), kv("name", "x"));
+
+        std::ifstream input(close_log_file());
+        std::string line;
+        std::getline(input, line);
+
+        BOOST_REQUIRE_EQUAL(line, "done code=42 name=x");
+    }
+
+    BOOST_FIXTURE_TEST_CASE(double_fields_locale_check, numeric_locale_cleanup)
+    {
+        print_current_test_name();
+
+        check_doubles_round_trip();
+
+        // Locales with decimal comma (if installed)
+        bool checked = false;
+        for (const char* name : { "de_DE.UTF-8", "de_DE.utf8", "ru_RU.UTF-8", "ru_RU.utf8", "fr_FR.UTF-8", "fr_FR.utf8" })
+        {
+            if (!setlocale(LC_NUMERIC, name))
+                continue;
+
+            check_doubles_round_trip();
+
+            std::string json;
+            server_lib::append_json_field(json, kv("ratio", 1.5));
+            BOOST_REQUIRE_EQUAL(json, ",\"ratio\":1.5");
+            checked = true;
+        }
+        if (!checked)
+            BOOST_TEST_MESSAGE("No decimal comma locale installed");
+    }
+
+    BOOST_AUTO_TEST_CASE(json_reused_key_buffer_check)
+    {
+        print_current_test_name();
+
+        // The same key buffer with other text
+        char key[8] = "first";
+        std::string json;
+        server_lib::append_json_field(json, kv(key, 1));
+        strcpy(key, "second");
+        server_lib::append_json_field(json, kv(key, 2));
+        BOOST_REQUIRE_EQUAL(json, ",\"first\":1,\"second\":2");
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
@@ -0,0 +1,74 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+
+namespace ll {
+namespace tests {
+
+    BOOST_FIXTURE_TEST_SUITE(lazy_tests, logger_cleanup)
+
+    BOOST_AUTO_TEST_CASE(lazy_filtered_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_info).set_details(logger::details_message_only);
+
+        create_log_file(current_test_name());
+
+        int calls = 0;
+        auto expensive = [&calls]() {
+            return ++calls;
+        };
+
+        LOG_DEBUG("skipped " << ll::lazy(expensive));
+        LOG_INFO("value " << ll::lazy(expensive) << " of " << std::setw(3) << 7 << std::endl
+                          << "next");
+
+        BOOST_REQUIRE_EQUAL(calls, 1);
+
+        std::ifstream input(close_log_file());
+        std::string line;
+        BOOST_REQUIRE(std::getline(input, line));
+        BOOST_REQUIRE_EQUAL(line, "value 1 of   7");
+        BOOST_REQUIRE(std::getline(input, line));
+        BOOST_REQUIRE_EQUAL(line, "next");
+    }
+
+    BOOST_AUTO_TEST_CASE(lazy_async_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_trace).set_details(logger::details_message_only).init_async_log();
+
+        create_log_file(current_test_name());
+
+        const auto producer = std::this_thread::get_id();
+        std::atomic<bool> rendered_by_producer { false };
+
+        std::string state = "initial";
+        LOG_INFO(ll::lazy([producer, &rendered_by_producer]() {
+                     rendered_by_producer = std::this_thread::get_id() == producer;
+                     return "lazy";
+                 })
+                 << " " << ll::lazy_copy(state));
+        // Copy was captured
+        state = "changed";
+
+        logger::instance().flush();
+        BOOST_REQUIRE(!rendered_by_producer);
+
+        std::ifstream input(close_log_file());
+        std::string line;
+        BOOST_REQUIRE(std::getline(input, line));
+        BOOST_REQUIRE_EQUAL(line, "lazy initial");
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
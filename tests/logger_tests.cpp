@@ -6,67 +6,22 @@
 #include <logger/time_helper.h>
 #include <logger/asserts.h>
 
+#include "format_helper.h"
+#include "text_writer.h"
+
 #if defined(SERVER_LIB_PLATFORM_LINUX)
 #include <unistd.h>
 #endif
 
 #include <fstream>
-#include <boost/filesystem.hpp>
-#include <memory>
+#include <thread>
+#include <chrono>
 
 namespace ll {
 namespace tests {
 
     using server_lib::to_iso_string;
 
-    class logger_cleanup
-    {
-    public:
-        logger_cleanup() = default;
-
-        ~logger_cleanup()
-        {
-            logger::destroy();
-            close_log_file();
-            if (!_temp_to_log.empty())
-            {
-                boost::filesystem::remove(_temp_to_log);
-            }
-        }
-
-        void create_log_file(const std::string& test_name)
-        {
-            std::string file_name = boost::filesystem::unique_path().generic_string();
-            file_name += '.';
-            file_name += test_name;
-
-            _temp_to_log = boost::filesystem::temp_directory_path() / file_name;
-
-            _tmp_file = std::unique_ptr<std::ofstream>(new std::ofstream(_temp_to_log.generic_string().c_str()));
-            std::cout.clear();
-            std::cout.rdbuf(_tmp_file->rdbuf());
-        }
-
-        std::string close_log_file()
-        {
-            if (_tmp_file)
-            {
-                _tmp_file->close();
-                _tmp_file.reset();
-                std::cout.rdbuf(pcout_old_buf);
-                return _temp_to_log.generic_string();
-            }
-            return {};
-        }
-
-    private:
-        boost::filesystem::path _temp_to_log;
-        std::unique_ptr<std::ofstream> _tmp_file;
-        static std::streambuf* pcout_old_buf;
-    };
-
-    std::streambuf* logger_cleanup::pcout_old_buf = std::cout.rdbuf();
-
     BOOST_FIXTURE_TEST_SUITE(logger_tests, logger_cleanup)
 
     BOOST_AUTO_TEST_CASE(default_level_check)
@@ -274,6 +229,110 @@ namespace tests {
         BOOST_REQUIRE_EQUAL(rows, 6);
     }
 
+    BOOST_AUTO_TEST_CASE(call_site_time_check)
+    {
+        print_current_test_name();
+
+        using std::chrono::system_clock;
+
+        auto before = system_clock::now();
+        logger::log_context context;
+        auto after = system_clock::now();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        // Converted later but keeps the time of construction
+        auto captured = context.time();
+        static const auto tolerance = std::chrono::milliseconds(2);
+        BOOST_REQUIRE(captured >= before - tolerance);
+        BOOST_REQUIRE(captured <= after + tolerance);
+
+        logger::log_context next_context;
+        BOOST_REQUIRE(next_context.timestamp >= context.timestamp);
+        BOOST_REQUIRE(next_context.time() >= captured);
+    }
+
+    BOOST_AUTO_TEST_CASE(message_buffer_check)
+    {
+        print_current_test_name();
+
+        auto text = [](const server_lib::message_stream& message) {
+            return std::string(message.text_data(), message.text_size());
+        };
+
+        logger::log_message msg;
+        BOOST_REQUIRE_EQUAL(msg.message.text_size(), 0u);
+        msg << "first " << 1;
+        BOOST_REQUIRE_EQUAL(text(msg.message), msg.message.str());
+
+        // Replaced text (as queued record decoding and lazy parts do)
+        msg.message.str("replaced");
+        BOOST_REQUIRE_EQUAL(text(msg.message), "replaced");
+        msg.message.seekp(0, std::ios_base::end);
+        msg << " and more";
+        BOOST_REQUIRE_EQUAL(text(msg.message), "replaced and more");
+
+        // Read position doesn't matter
+        char buff[4];
+        msg.message.rdbuf()->sgetn(buff, sizeof(buff));
+        BOOST_REQUIRE_EQUAL(text(msg.message), msg.message.str());
+
+        // Moved with record (as spilled async record is)
+        logger::log_message moved(std::move(msg));
+        BOOST_REQUIRE_EQUAL(text(moved.message), "replaced and more");
+        moved << "!";
+        BOOST_REQUIRE_EQUAL(moved.message.str(), "replaced and more!");
+    }
+
+    BOOST_AUTO_TEST_CASE(cli_renderers_check)
+    {
+        print_current_test_name();
+
+        static const char* time_format = "%Y-%m-%d %H:%M:%S";
+
+        logger::log_message msg;
+        msg.context.lv = logger::level::warning;
+        msg.context.file = "file.cpp";
+        msg.context.line = 12;
+        msg.context.thread_info = std::make_tuple(77, std::string("worker"), false);
+        msg << "text";
+        msg.add_fields(kv("n", 1));
+
+        // 2021-01-02 03:04:05.000006 (local time of renderer)
+        const std::time_t seconds = 1609556645;
+        const auto time = logger::clock_type::from_time_t(seconds) + std::chrono::microseconds(6);
+        const auto date = to_iso_string(seconds, time_format, false);
+
+        for (int details = 0; details < 64; ++details)
+        {
+            auto has = [details](logger::details detail) {
+                return (~details & static_cast<int>(detail)) != 0;
+            };
+
+            std::string expected;
+            if (has(logger::details::without_app_name))
+                expected += "app: ";
+            if (has(logger::details::without_time))
+            {
+                expected += date;
+                if (has(logger::details::without_microseconds))
+                    expected += ".6 ";
+            }
+            if (has(logger::details::without_level))
+                expected += " [warning] ";
+            if (has(logger::details::without_thread_info))
+                expected += "[77-worker]";
+            expected += "text n=1";
+            if (has(logger::details::without_source_code))
+                expected += " (from file.cpp:12)";
+            expected += '\n';
+
+            std::string row;
+            server_lib::select_cli_renderer(details)(row, msg, time, time_format, "app", false);
+            BOOST_REQUIRE_EQUAL(row, expected);
+        }
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
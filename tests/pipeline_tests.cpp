@@ -0,0 +1,168 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        // Counts records reached the stage
+        struct counting_stage
+        {
+            explicit counting_stage(size_t& counter)
+                : _counter(&counter)
+            {
+            }
+
+            bool operator()(pipeline_record&)
+            {
+                ++(*_counter);
+                return true;
+            }
+
+        private:
+            size_t* _counter;
+        };
+
+        // Keeps texts of records passed by previous stages
+        struct collecting_sink
+        {
+            explicit collecting_sink(std::vector<std::string>& texts)
+                : _texts(&texts)
+            {
+            }
+
+            bool operator()(pipeline_record& record)
+            {
+                _texts->push_back(record.text);
+                return true;
+            }
+
+            void flush()
+            {
+                ++flushes;
+            }
+
+            static size_t flushes;
+
+        private:
+            std::vector<std::string>* _texts;
+        };
+
+        size_t collecting_sink::flushes = 0;
+
+        std::string read_file(const std::string& path)
+        {
+            std::ifstream input(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        }
+    } // namespace
+
+    BOOST_FIXTURE_TEST_SUITE(pipeline_tests, logger_cleanup)
+
+    BOOST_AUTO_TEST_CASE(pipeline_stages_check)
+    {
+        print_current_test_name();
+
+        size_t before_filter = 0;
+        size_t after_filter = 0;
+        std::vector<std::string> texts;
+        std::stringstream stream;
+
+        auto& log = logger::instance();
+        log.add_destination(make_pipeline(counting_stage(before_filter),
+                                          level_filter(logger::level_info),
+                                          counting_stage(after_filter),
+                                          render_text(),
+                                          collecting_sink(texts),
+                                          stream_sink(stream)))
+            .set_level(logger::level_trace)
+            .set_details(logger::details_message_with_level);
+        log.unlock();
+
+        collecting_sink::flushes = 0;
+
+        LOG_DEBUG("skipped");
+        LOG_INFO("first");
+        LOG_WARN("second " << 2);
+        log.flush();
+
+        BOOST_REQUIRE_EQUAL(before_filter, 3);
+        BOOST_REQUIRE_EQUAL(after_filter, 2);
+        BOOST_REQUIRE_EQUAL(collecting_sink::flushes, 1);
+
+        BOOST_REQUIRE_EQUAL(texts.size(), 2);
+        BOOST_REQUIRE_EQUAL(texts[0], "    [info] first\n");
+        BOOST_REQUIRE_EQUAL(texts[1], " [warning] second 2\n");
+        BOOST_REQUIRE_EQUAL(stream.str(), texts[0] + texts[1]);
+    }
+
+    BOOST_AUTO_TEST_CASE(pipeline_with_handlers_check)
+    {
+        print_current_test_name();
+
+        std::vector<std::string> texts;
+        size_t handled = 0;
+
+        auto& log = logger::instance();
+        log.add_destination([&handled](const logger::log_message&, int) {
+               ++handled;
+           })
+            .add_destination(make_pipeline(render_json(), collecting_sink(texts)))
+            .set_level(logger::level_trace);
+        log.unlock();
+
+        BOOST_REQUIRE_EQUAL(log.get_appenders_count(), 2);
+
+        // Levels of pipeline destination are set as for others
+        log.set_destination_level(1, logger::level_info);
+
+        LOG_DEBUG("debug");
+        LOG_ERROR("failed");
+        log.flush();
+
+        BOOST_REQUIRE_EQUAL(handled, 2);
+        BOOST_REQUIRE_EQUAL(texts.size(), 1);
+        BOOST_REQUIRE(texts[0].find("\"message\":\"failed\"") != std::string::npos);
+
+        auto stats = log.stats();
+        BOOST_REQUIRE_EQUAL(stats.destinations.size(), 2);
+        BOOST_REQUIRE_EQUAL(stats.destinations[0].records, 2);
+        BOOST_REQUIRE_EQUAL(stats.destinations[1].records, 1);
+    }
+
+    BOOST_AUTO_TEST_CASE(pipeline_file_sink_check)
+    {
+        print_current_test_name();
+
+        const auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).generic_string() + ".log";
+
+        auto& log = logger::instance();
+        log.add_destination(make_pipeline(level_filter(logger::level_debug),
+                                          render_text(),
+                                          file_sink(path)))
+            .set_level(logger::level_trace)
+            .set_details(logger::details_message_only)
+            .init_async_log();
+        log.unlock();
+
+        LOG_TRACE("skipped");
+        LOG_INFO("first");
+        LOG_DEBUG("second " << 2);
+        log.flush();
+
+        BOOST_REQUIRE_EQUAL(read_file(path), "first\nsecond 2\n");
+
+        logger::destroy();
+        boost::filesystem::remove(path);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
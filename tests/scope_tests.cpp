@@ -0,0 +1,141 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include <fstream>
+#include <memory>
+#include <vector>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        std::vector<std::string> read_lines(const std::string& path)
+        {
+            std::ifstream input(path);
+            std::vector<std::string> lines;
+            for (std::string line; std::getline(input, line);)
+                lines.push_back(line);
+            return lines;
+        }
+
+        void handle_request(int id, bool fail)
+        {
+            ll::buffered_scope scope;
+
+            LOG_DEBUG("request " << id << " parsed");
+            LOG_TRACE("request " << id << " routed");
+            LOG_INFO("request " << id << " started");
+            if (fail)
+            {
+                LOG_ERROR("request " << id << " failed");
+                LOG_DEBUG("request " << id << " cleaned");
+            }
+        }
+    } // namespace
+
+    BOOST_FIXTURE_TEST_SUITE(scope_tests, logger_cleanup)
+
+    BOOST_AUTO_TEST_CASE(buffered_scope_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_info).set_details(logger::details_message_only);
+
+        create_log_file(current_test_name());
+
+        handle_request(1, false);
+        handle_request(2, true);
+        handle_request(3, false);
+        LOG_DEBUG("filtered");
+
+        auto lines = read_lines(close_log_file());
+        std::vector<std::string> expected = {
+            "request 1 started",
+            // Kept records are in order before error
+            "request 2 started",
+            "request 2 parsed",
+            "request 2 routed",
+            "request 2 failed",
+            "request 2 cleaned",
+            "request 3 started",
+        };
+        // Info record isn't kept, so it is written before
+        BOOST_REQUIRE_EQUAL(lines.size(), expected.size());
+        for (size_t ci = 0; ci < lines.size(); ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(lines[ci], expected[ci]);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(buffered_scope_commit_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_warning).set_details(logger::details_message_only).init_async_log();
+
+        create_log_file(current_test_name());
+
+        {
+            ll::buffered_scope outer(logger::level::warning);
+            LOG_INFO("outer " << ll::lazy([]() { return 1; }));
+            {
+                ll::buffered_scope inner(logger::level::info, 2);
+                for (int ci = 0; ci < 5; ++ci)
+                {
+                    LOG_DEBUG("inner " << ci);
+                }
+                BOOST_REQUIRE_EQUAL(inner.size(), 2);
+                BOOST_REQUIRE_EQUAL(inner.dropped(), 3);
+                inner.commit();
+                BOOST_REQUIRE(inner.committed());
+                LOG_DEBUG("inner 5");
+            }
+            BOOST_REQUIRE_EQUAL(outer.size(), 1);
+            outer.discard();
+        }
+        LOG_INFO("filtered");
+
+        logger::instance().flush();
+
+        auto lines = read_lines(close_log_file());
+        std::vector<std::string> expected = { "inner 3", "inner 4", "inner 5" };
+        BOOST_REQUIRE_EQUAL(lines.size(), expected.size());
+        for (size_t ci = 0; ci < lines.size(); ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(lines[ci], expected[ci]);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(buffered_scope_out_of_order_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_info).set_details(logger::details_message_only);
+
+        create_log_file(current_test_name());
+
+        std::unique_ptr<ll::buffered_scope> outer(new ll::buffered_scope());
+        LOG_DEBUG("outer");
+        {
+            ll::buffered_scope inner;
+            LOG_DEBUG("inner");
+            // Outer one is unlinked with its records
+            outer.reset();
+            LOG_ERROR("failed");
+        }
+        LOG_DEBUG("filtered");
+
+        auto lines = read_lines(close_log_file());
+        std::vector<std::string> expected = { "inner", "failed" };
+        BOOST_REQUIRE_EQUAL(lines.size(), expected.size());
+        for (size_t ci = 0; ci < lines.size(); ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(lines[ci], expected[ci]);
+        }
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
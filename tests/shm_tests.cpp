@@ -0,0 +1,104 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include "shm_ring.h"
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        std::string unique_shm_name()
+        {
+            return "ll_tests_" + std::to_string(getpid()) + "_" + current_test_name();
+        }
+    } // namespace
+
+    BOOST_FIXTURE_TEST_SUITE(shm_tests, logger_cleanup)
+
+    BOOST_AUTO_TEST_CASE(shm_records_check)
+    {
+        print_current_test_name();
+
+        const auto name = unique_shm_name();
+
+        logger::instance().init_shm_log(name).set_level(logger::level_trace);
+
+        server_lib::shm_ring_reader reader(name);
+
+        LOG_INFO("first " << 1);
+        LOG_WARN_KV("second", kv("code", 42));
+
+        std::vector<std::string> messages;
+        std::vector<int> levels;
+        std::vector<std::string> files;
+        auto handler = [&](const server_lib::shm_record& record) {
+            messages.emplace_back(record.message.data, record.message.size);
+            levels.push_back(record.level);
+            files.emplace_back(record.file.data, record.file.size);
+        };
+        reader.read(handler, std::chrono::milliseconds(10));
+
+        BOOST_REQUIRE_EQUAL(messages.size(), 2);
+        BOOST_REQUIRE_EQUAL(messages[0], "first 1");
+        BOOST_REQUIRE_EQUAL(messages[1], "second code=42");
+        BOOST_REQUIRE_EQUAL(levels[0], static_cast<int>(logger::level::info));
+        BOOST_REQUIRE_EQUAL(levels[1], static_cast<int>(logger::level::warning));
+        BOOST_REQUIRE(files[0].find("shm_tests.cpp") != std::string::npos);
+        BOOST_REQUIRE_EQUAL(reader.drops(), 0);
+        BOOST_REQUIRE(!reader.closed());
+
+        logger::destroy();
+
+        BOOST_REQUIRE(reader.closed());
+    }
+
+    BOOST_AUTO_TEST_CASE(shm_overflow_check)
+    {
+        print_current_test_name();
+
+        const auto name = unique_shm_name();
+
+        // Minimal ring without reader must not block application
+        logger::instance().init_shm_log(name, 4096).set_level(logger::level_trace);
+
+        const size_t records = 1000;
+        for (size_t ci = 0; ci < records; ++ci)
+        {
+            LOG_INFO("record " << ci);
+        }
+
+        server_lib::shm_ring_reader reader(name);
+        BOOST_REQUIRE(reader.drops() > 0);
+        BOOST_REQUIRE(reader.drops() < records);
+        BOOST_REQUIRE_EQUAL(logger::instance().stats().drops, reader.drops());
+
+        // Reader releases space for new records
+        size_t handled = 0;
+        uint64_t previous_id = 0;
+        reader.read([&](const server_lib::shm_record& record) {
+            BOOST_REQUIRE(record.id > previous_id);
+            previous_id = record.id;
+            ++handled;
+        },
+                    std::chrono::milliseconds(10));
+        BOOST_REQUIRE_EQUAL(handled + reader.drops(), records);
+
+        LOG_INFO("after drain");
+        size_t after = 0;
+        reader.read([&](const server_lib::shm_record&) {
+            ++after;
+        },
+                    std::chrono::milliseconds(10));
+        BOOST_REQUIRE_EQUAL(after, 1);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
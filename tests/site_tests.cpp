@@ -0,0 +1,261 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        std::vector<std::string> read_lines(const std::string& path)
+        {
+            std::ifstream input(path);
+            std::vector<std::string> lines;
+            for (std::string line; std::getline(input, line);)
+                lines.push_back(line);
+            return lines;
+        }
+
+        void hot_loop(int count)
+        {
+            for (int ci = 0; ci < count; ++ci)
+            {
+                LOG_TRACE("iteration " << ci);
+            }
+        }
+
+        void noisy_function()
+        {
+            LOG_INFO("noise");
+        }
+
+        size_t registered_sites(const std::string& function)
+        {
+            size_t result = 0;
+            log_site::for_each([&](const log_site& site) {
+                if (function == site.function())
+                    ++result;
+            });
+            return result;
+        }
+
+        // Sites are global, so rules and counters are dropped after test
+        struct sites_cleanup : public logger_cleanup
+        {
+            ~sites_cleanup()
+            {
+                log_site::reset_modes();
+                log_site::reset_counters();
+            }
+        };
+    } // namespace
+
+    BOOST_FIXTURE_TEST_SUITE(site_tests, sites_cleanup)
+
+    BOOST_AUTO_TEST_CASE(site_switch_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_info).set_details(logger::details_message_only);
+
+        create_log_file(current_test_name());
+
+        // Rule is applied to site registered later
+        logger::instance().set_sites("func noisy_*", site_mode::off);
+        noisy_function();
+        BOOST_REQUIRE_EQUAL(registered_sites("noisy_function"), 1);
+
+        hot_loop(2);
+        BOOST_REQUIRE_EQUAL(registered_sites("hot_loop"), 1);
+
+        // Single trace line without trace level
+        BOOST_REQUIRE_EQUAL(log_site::set_mode("file site_tests.cpp func hot_loop", site_mode::on), 1);
+        hot_loop(2);
+        BOOST_REQUIRE_EQUAL(log_site::set_mode("func hot_loop", site_mode::level), 1);
+        hot_loop(2);
+
+        logger::instance().set_sites("func noisy_function", site_mode::level);
+        noisy_function();
+
+        auto lines = read_lines(close_log_file());
+        std::vector<std::string> expected = {
+            "iteration 0",
+            "iteration 1",
+            "noise",
+        };
+        BOOST_REQUIRE_EQUAL(lines.size(), expected.size());
+        for (size_t ci = 0; ci < lines.size(); ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(lines[ci], expected[ci]);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(site_query_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_trace).set_details(logger::details_message_only);
+
+        create_log_file(current_test_name());
+
+        for (int ci = 0; ci < 3; ++ci)
+        {
+            LOG_INFO("first");
+            const int second_line = __LINE__ + 1;
+            LOG_INFO("second");
+
+            if (!ci)
+            {
+                const std::string line_query = "file *tests/site_* line " + std::to_string(second_line);
+                BOOST_REQUIRE_EQUAL(log_site::set_mode(line_query, site_mode::off), 1);
+                BOOST_REQUIRE_EQUAL(log_site::set_mode("file site_tests.cpp line 1", site_mode::off), 0);
+                BOOST_REQUIRE_EQUAL(log_site::set_mode("file other?.cpp", site_mode::off), 0);
+            }
+        }
+
+        BOOST_REQUIRE_THROW(log_site::set_mode("", site_mode::on), std::logic_error);
+        BOOST_REQUIRE_THROW(log_site::set_mode("file", site_mode::on), std::logic_error);
+        BOOST_REQUIRE_THROW(log_site::set_mode("line x", site_mode::on), std::logic_error);
+        BOOST_REQUIRE_THROW(log_site::set_mode("path a.cpp", site_mode::on), std::logic_error);
+
+        auto lines = read_lines(close_log_file());
+        std::vector<std::string> expected = {
+            "first",
+            "second",
+            "first",
+            "first",
+        };
+        BOOST_REQUIRE_EQUAL(lines.size(), expected.size());
+        for (size_t ci = 0; ci < lines.size(); ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(lines[ci], expected[ci]);
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(site_config_check)
+    {
+        print_current_test_name();
+
+        const auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).generic_string() + ".conf";
+        {
+            std::ofstream config(path);
+            config << "level=info\n";
+            config << "site.on=func hot_loop\n";
+        }
+
+        logger::instance().init_cli_log().set_details(logger::details_message_only).load_config(path);
+
+        create_log_file(current_test_name());
+
+        hot_loop(1);
+        LOG_TRACE("skipped");
+
+        auto lines = read_lines(close_log_file());
+        BOOST_REQUIRE_EQUAL(lines.size(), 1);
+        BOOST_REQUIRE_EQUAL(lines[0], "iteration 0");
+
+        auto stats = logger::instance().stats();
+        BOOST_REQUIRE_EQUAL(stats.filtered[logger::level_index(logger::level::trace)], 1);
+
+        // Rule removed from config is dropped by reload, other rules are kept
+        logger::instance().set_sites("func noisy_function", site_mode::off);
+        {
+            std::ofstream config(path);
+            config << "level=info\n";
+        }
+        logger::instance().load_config(path);
+
+        create_log_file(current_test_name());
+
+        hot_loop(1);
+        noisy_function();
+        LOG_INFO("written");
+
+        lines = read_lines(close_log_file());
+        BOOST_REQUIRE_EQUAL(lines.size(), 1);
+        BOOST_REQUIRE_EQUAL(lines[0], "written");
+
+        boost::filesystem::remove(path);
+    }
+
+    BOOST_AUTO_TEST_CASE(site_profile_check)
+    {
+        print_current_test_name();
+
+        log_site::reset_counters();
+        logger::instance().init_cli_log().set_level(logger::level_info).set_details(logger::details_message_only).set_site_profiling(true, 1);
+
+        create_log_file(current_test_name());
+
+        const std::string large(1000, 'x');
+        for (int ci = 0; ci < 100; ++ci)
+        {
+            LOG_DEBUG("filtered " << ci);
+        }
+        for (int ci = 0; ci < 10; ++ci)
+        {
+            LOG_INFO(large);
+        }
+
+        close_log_file();
+
+        auto profile = logger::instance().dump_site_profile(1);
+        BOOST_REQUIRE_EQUAL(profile.by_hits.size(), 1);
+        BOOST_REQUIRE_EQUAL(profile.by_bytes.size(), 1);
+        BOOST_REQUIRE_EQUAL(profile.by_time.size(), 1);
+
+        const auto& by_hits = profile.by_hits[0];
+        BOOST_REQUIRE_EQUAL(by_hits.hits, 100);
+        BOOST_REQUIRE_EQUAL(by_hits.filtered, 100);
+        BOOST_REQUIRE(by_hits.lv == logger::level::debug);
+        BOOST_REQUIRE_EQUAL(by_hits.method, "test_method");
+        BOOST_REQUIRE(by_hits.file.find("site_tests.cpp") != std::string::npos);
+
+        const auto& by_bytes = profile.by_bytes[0];
+        BOOST_REQUIRE_EQUAL(by_bytes.hits, 10);
+        BOOST_REQUIRE_EQUAL(by_bytes.filtered, 0);
+        BOOST_REQUIRE_EQUAL(by_bytes.bytes, 10 * large.size());
+        BOOST_REQUIRE_EQUAL(by_bytes.line, by_hits.line + 4);
+
+        BOOST_REQUIRE(profile.by_time[0].time.count() > 0);
+
+        // Not counted when switched off
+        logger::instance().set_site_profiling(false);
+        LOG_DEBUG("not counted");
+        BOOST_REQUIRE_EQUAL(logger::instance().dump_site_profile().by_hits.size(), 2);
+    }
+
+    BOOST_AUTO_TEST_CASE(site_profile_off_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_info).set_details(logger::details_message_only).set_site_profiling(true, 1);
+
+        create_log_file(current_test_name());
+
+        // The first hit registers site, next ones are skipped by macro
+        logger::instance().set_sites("func noisy_*", site_mode::off);
+        for (int ci = 0; ci < 5; ++ci)
+        {
+            noisy_function();
+        }
+
+        BOOST_REQUIRE(read_lines(close_log_file()).empty());
+
+        auto profile = logger::instance().dump_site_profile(1);
+        BOOST_REQUIRE_EQUAL(profile.by_hits.size(), 1);
+
+        const auto& by_hits = profile.by_hits[0];
+        BOOST_REQUIRE_EQUAL(by_hits.method, "noisy_function");
+        BOOST_REQUIRE_EQUAL(by_hits.hits, 5);
+        BOOST_REQUIRE_EQUAL(by_hits.filtered, 5);
+        BOOST_REQUIRE_EQUAL(by_hits.bytes, 0);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
@@ -0,0 +1,101 @@
+#include "tests_common.h"
+
+#include <logger/ll.h>
+
+#include <fstream>
+#include <numeric>
+#include <thread>
+#include <chrono>
+
+namespace ll {
+namespace tests {
+
+    BOOST_FIXTURE_TEST_SUITE(stats_tests, logger_cleanup)
+
+    BOOST_AUTO_TEST_CASE(stats_counters_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_level(logger::level_warning);
+
+        create_log_file(current_test_name());
+
+        LOG_TRACE("filtered");
+        LOG_DEBUG("filtered");
+        LOG_INFO("filtered");
+        LOG_WARN("accepted");
+        LOG_ERROR("accepted");
+        LOG_ERROR("accepted");
+
+        auto stats = logger::instance().stats();
+
+        close_log_file();
+
+        using lv = logger::level;
+        BOOST_REQUIRE_EQUAL(stats.filtered[logger::level_index(lv::trace)], 1);
+        BOOST_REQUIRE_EQUAL(stats.filtered[logger::level_index(lv::debug)], 1);
+        BOOST_REQUIRE_EQUAL(stats.filtered[logger::level_index(lv::info)], 1);
+        BOOST_REQUIRE_EQUAL(stats.accepted[logger::level_index(lv::warning)], 1);
+        BOOST_REQUIRE_EQUAL(stats.accepted[logger::level_index(lv::error)], 2);
+        BOOST_REQUIRE_EQUAL(stats.accepted[logger::level_index(lv::fatal)], 0);
+
+        BOOST_REQUIRE_EQUAL(stats.destinations.size(), 1);
+        BOOST_REQUIRE_EQUAL(stats.destinations[0].records, 3);
+        BOOST_REQUIRE(stats.destinations[0].bytes > 3 * std::string("accepted").size());
+        BOOST_REQUIRE_EQUAL(stats.drops, 0);
+
+        auto written = std::accumulate(stats.write_latency.begin(), stats.write_latency.end(), uint64_t(0));
+        BOOST_REQUIRE_EQUAL(written, 3);
+    }
+
+    BOOST_AUTO_TEST_CASE(stats_async_check)
+    {
+        print_current_test_name();
+
+        logger::async_options options;
+        options.queue_capacity = 128;
+
+        logger::instance().init_cli_log().init_async_log(options);
+
+        create_log_file(current_test_name());
+
+        for (int ci = 0; ci < 1000; ++ci)
+        {
+            LOG_INFO(ci);
+        }
+        logger::instance().flush();
+
+        auto stats = logger::instance().stats();
+
+        close_log_file();
+
+        BOOST_REQUIRE_EQUAL(stats.destinations[0].records, 1000);
+        BOOST_REQUIRE(stats.queue_high_water <= 128);
+    }
+
+    BOOST_AUTO_TEST_CASE(stats_emit_check)
+    {
+        print_current_test_name();
+
+        logger::instance().init_cli_log().set_details(logger::details_message_only).set_stats_period(std::chrono::milliseconds(1));
+
+        create_log_file(current_test_name());
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        LOG_INFO("payload");
+
+        std::ifstream input(close_log_file());
+
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(input, line);)
+            lines.push_back(line);
+
+        BOOST_REQUIRE_EQUAL(lines.size(), 2);
+        BOOST_REQUIRE_EQUAL(lines[0], "payload");
+        BOOST_REQUIRE(lines[1].find("logger stats accepted=1") == 0);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
@@ -30,5 +30,7 @@ namespace tests {
         DUMP_STR(ss.str());
     }
 
+    std::streambuf* logger_cleanup::pcout_old_buf = std::cout.rdbuf();
+
 } // namespace tests
 } // namespace ll
@@ -1,8 +1,14 @@
 #pragma once
 
 #include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include <logger/ll.h>
 
 #include <string>
+#include <fstream>
+#include <iostream>
+#include <memory>
 
 namespace ll {
 namespace tests {
@@ -19,6 +25,52 @@ namespace tests {
     std::string current_test_name();
     void print_current_test_name();
 
+    class logger_cleanup
+    {
+    public:
+        logger_cleanup() = default;
+
+        ~logger_cleanup()
+        {
+            logger::destroy();
+            close_log_file();
+            if (!_temp_to_log.empty())
+            {
+                boost::filesystem::remove(_temp_to_log);
+            }
+        }
+
+        void create_log_file(const std::string& test_name)
+        {
+            std::string file_name = boost::filesystem::unique_path().generic_string();
+            file_name += '.';
+            file_name += test_name;
+
+            _temp_to_log = boost::filesystem::temp_directory_path() / file_name;
+
+            _tmp_file = std::unique_ptr<std::ofstream>(new std::ofstream(_temp_to_log.generic_string().c_str()));
+            std::cout.clear();
+            std::cout.rdbuf(_tmp_file->rdbuf());
+        }
+
+        std::string close_log_file()
+        {
+            if (_tmp_file)
+            {
+                _tmp_file->close();
+                _tmp_file.reset();
+                std::cout.rdbuf(pcout_old_buf);
+                return _temp_to_log.generic_string();
+            }
+            return {};
+        }
+
+    private:
+        boost::filesystem::path _temp_to_log;
+        std::unique_ptr<std::ofstream> _tmp_file;
+        static std::streambuf* pcout_old_buf;
+    };
+
 } // namespace tests
 } // namespace ll
 
@@ -0,0 +1,167 @@
+#include "tests_common.h"
+
+#include <logger/time_helper.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace ll {
+namespace tests {
+
+    namespace {
+        std::string libc_format(time_t t, const char* format, bool should_utc)
+        {
+            std::tm tp {};
+            if (should_utc)
+                gmtime_r(&t, &tp);
+            else
+                localtime_r(&t, &tp);
+            char buff[100];
+            auto size = std::strftime(buff, sizeof(buff), format, &tp);
+            return { buff, size };
+        }
+
+        // Time zone of test, the previous one is restored
+        struct time_zone_guard
+        {
+            explicit time_zone_guard(const char* zone)
+            {
+                auto previous = getenv("TZ");
+                had_previous = previous != nullptr;
+                if (had_previous)
+                    previous_zone = previous;
+                set(zone);
+            }
+
+            ~time_zone_guard()
+            {
+                if (had_previous)
+                    setenv("TZ", previous_zone.c_str(), 1);
+                else
+                    unsetenv("TZ");
+                tzset();
+            }
+
+            void set(const char* zone)
+            {
+                setenv("TZ", zone, 1);
+                tzset();
+            }
+
+            bool had_previous = false;
+            std::string previous_zone;
+        };
+    } // namespace
+
+    BOOST_AUTO_TEST_SUITE(time_tests)
+
+    BOOST_AUTO_TEST_CASE(format_as_libc_check)
+    {
+        print_current_test_name();
+
+        const char* formats[] = { logger::default_time_format, "%Y-%m-%d %H:%M:%S", "%d/%m/%Y", "%H:%M", "%b %d %Y" };
+
+        // From 1970 to 2100 with odd step to visit different days and seconds
+        for (time_t t = 0; t < 4102444800; t += 7777777)
+        {
+            for (auto format : formats)
+            {
+                for (bool should_utc : { true, false })
+                {
+                    char buff[64];
+                    size_t size = 0;
+                    BOOST_REQUIRE_EQUAL(server_lib::format_iso_time(t, format, buff, sizeof(buff), size, should_utc), 0);
+                    BOOST_REQUIRE_EQUAL(std::string(buff, size), libc_format(t, format, should_utc));
+                }
+            }
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(parse_round_trip_check)
+    {
+        print_current_test_name();
+
+        for (time_t t = 0; t < 4102444800; t += 7777777)
+        {
+            for (bool should_utc : { true, false })
+            {
+                auto text = libc_format(t, logger::default_time_format, should_utc);
+
+                time_t parsed = 0;
+                BOOST_REQUIRE_EQUAL(server_lib::parse_iso_time(text.data(), text.size(), logger::default_time_format, parsed, should_utc), 0);
+                BOOST_REQUIRE_EQUAL(parsed, t);
+                BOOST_REQUIRE_EQUAL(server_lib::from_iso_string(text, logger::default_time_format, should_utc), t);
+            }
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(local_offset_change_check)
+    {
+        print_current_test_name();
+
+        // +05:30 zone with daylight time since 2024-03-10 02:00,
+        // that is 2024-03-09 20:30 UTC
+        time_zone_guard zone("XST-5:30XDT,M3.2.0/2,M11.1.0/2");
+
+        const time_t hour_begin = 1710014400;
+        for (time_t t = hour_begin; t < hour_begin + 3600; t += 300)
+        {
+            char buff[64];
+            size_t size = 0;
+            BOOST_REQUIRE_EQUAL(server_lib::format_iso_time(t, logger::default_time_format, buff, sizeof(buff), size, false), 0);
+            BOOST_REQUIRE_EQUAL(std::string(buff, size), libc_format(t, logger::default_time_format, false));
+        }
+
+        // The same time after time zone is changed
+        zone.set("YST3");
+        char buff[64];
+        size_t size = 0;
+        BOOST_REQUIRE_EQUAL(server_lib::format_iso_time(hour_begin, logger::default_time_format, buff, sizeof(buff), size, false), 0);
+        BOOST_REQUIRE_EQUAL(std::string(buff, size), "2024-03-09T17:00:00");
+    }
+
+    BOOST_AUTO_TEST_CASE(parse_daylight_time_check)
+    {
+        print_current_test_name();
+
+        time_zone_guard zone("EST5EDT,M3.2.0,M11.1.0");
+
+        // 2024-07-01T16:00:00Z
+        const time_t summer = 1719849600;
+        BOOST_REQUIRE_EQUAL(server_lib::from_iso_string("2024-07-01T12:00:00", logger::default_time_format, false), summer);
+        BOOST_REQUIRE_EQUAL(server_lib::from_iso_string("2024-07-01T16:00:00", logger::default_time_format, true), summer);
+
+        // 2024-01-01T17:00:00Z
+        const time_t winter = 1704128400;
+        BOOST_REQUIRE_EQUAL(server_lib::from_iso_string("2024-01-01T12:00:00", logger::default_time_format, false), winter);
+        BOOST_REQUIRE_EQUAL(server_lib::from_iso_string("2024-01-01T17:00:00", logger::default_time_format, true), winter);
+    }
+
+    BOOST_AUTO_TEST_CASE(errors_check)
+    {
+        print_current_test_name();
+
+        time_t parsed = 0;
+        const char garbage[] = "2024-0x-01T00:00:00";
+        BOOST_REQUIRE_EQUAL(server_lib::parse_iso_time(garbage, strlen(garbage), logger::default_time_format, parsed), EINVAL);
+        BOOST_REQUIRE_EQUAL(server_lib::from_iso_string(garbage, logger::default_time_format), 0);
+
+        const char wrong_month[] = "2024-13-01T00:00:00";
+        BOOST_REQUIRE_EQUAL(server_lib::parse_iso_time(wrong_month, strlen(wrong_month), logger::default_time_format, parsed), EINVAL);
+
+        // Generic path
+        const char short_fields[] = "2024-1-2T3:04:05";
+        BOOST_REQUIRE_EQUAL(server_lib::parse_iso_time(short_fields, strlen(short_fields), logger::default_time_format, parsed), 0);
+        BOOST_REQUIRE_EQUAL(server_lib::to_iso_string(parsed, logger::default_time_format), "2024-01-02T03:04:05");
+
+        char buff[8];
+        size_t size = 0;
+        BOOST_REQUIRE_EQUAL(server_lib::format_iso_time(0, logger::default_time_format, buff, sizeof(buff), size), ERANGE);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ll
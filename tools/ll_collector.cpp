@@ -0,0 +1,203 @@
+// Reads records of init_shm_log from shared memory and renders them
+// to file, standard output or syslog out of the application process
+//
+// ll-collector --shm NAME [--file PATH] [--syslog] [--time-format FMT] [--once]
+
+#include <logger/logger.h>
+#include <logger/platform_config.h>
+
+#include "shm_ring.h"
+#include "text_writer.h"
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <syslog.h>
+#endif
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+using server_lib::logger;
+using server_lib::shm_record;
+using server_lib::shm_ring_reader;
+
+struct options
+{
+    std::string shm_name;
+    std::string file_path;
+    bool to_syslog = false;
+    std::string time_format = logger::default_time_format;
+    bool once = false;
+};
+
+void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program
+              << " --shm NAME [--file PATH] [--syslog] [--time-format FMT] [--once]\n";
+}
+
+bool parse_options(int argc, char* argv[], options& result)
+{
+    for (int ci = 1; ci < argc; ++ci)
+    {
+        const std::string arg = argv[ci];
+        const bool has_value = ci + 1 < argc;
+        if (arg == "--shm" && has_value)
+            result.shm_name = argv[++ci];
+        else if (arg == "--file" && has_value)
+            result.file_path = argv[++ci];
+        else if (arg == "--time-format" && has_value)
+            result.time_format = argv[++ci];
+        else if (arg == "--syslog")
+            result.to_syslog = true;
+        else if (arg == "--once")
+            result.once = true;
+        else
+            return false;
+    }
+    return !result.shm_name.empty();
+}
+
+std::unique_ptr<shm_ring_reader> attach(const std::string& name)
+{
+    // Wait for application
+    for (;;)
+    {
+        try
+        {
+            return std::unique_ptr<shm_ring_reader>(new shm_ring_reader(name));
+        }
+        catch (const std::exception&)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+}
+
+class collector
+{
+public:
+    explicit collector(const options& opts)
+        : _options(opts)
+    {
+        if (!_options.file_path.empty())
+        {
+            _file.open(_options.file_path.c_str(), std::ios::out | std::ios::app);
+            if (!_file)
+                throw std::runtime_error("Can't open " + _options.file_path);
+        }
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        if (_options.to_syslog)
+            openlog(NULL, LOG_CONS | LOG_PID | LOG_NDELAY, LOG_LOCAL2);
+#endif
+    }
+
+    void run()
+    {
+        for (;;)
+        {
+            auto reader = attach(_options.shm_name);
+            const auto application_name = reader->application_name();
+            uint64_t reported_drops = 0;
+
+            auto handler = [&](const shm_record& record) {
+                render(record, application_name);
+            };
+
+            for (;;)
+            {
+                // Check before read to not lose records committed before close
+                const bool closed = reader->closed();
+                const auto handled = reader->read(handler, std::chrono::milliseconds(200));
+
+                const auto drops = reader->drops();
+                if (drops > reported_drops)
+                {
+                    std::cerr << "ll-collector: " << (drops - reported_drops) << " records dropped by writer" << std::endl;
+                    reported_drops = drops;
+                }
+
+                if (handled)
+                    output().flush();
+                else if (closed)
+                    break;
+            }
+
+            if (_options.once)
+                return;
+        }
+    }
+
+private:
+    std::ostream& output()
+    {
+        if (_file.is_open())
+            return _file;
+        return std::cout;
+    }
+
+    void render(const shm_record& record, const std::string& application_name)
+    {
+        auto& context = _msg.context;
+        context.id = record.id;
+        context.lv = static_cast<logger::level>(record.level);
+        context.file.assign(record.file.data, record.file.size);
+        context.line = record.line;
+        context.method.assign(record.method.data, record.method.size);
+        context.thread_info = std::make_tuple(record.thread_id,
+                                              std::string(record.thread_name.data, record.thread_name.size),
+                                              record.thread_main != 0);
+        _msg.message.str(std::string(record.message.data, record.message.size));
+
+        if (_options.to_syslog)
+        {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+            auto text = server_lib::render_syslog_text(_msg, record.details_filter);
+            syslog(server_lib::to_syslog_level(context.lv), "%s", text.c_str());
+#endif
+            return;
+        }
+
+        const logger::clock_type::time_point time { std::chrono::duration_cast<logger::clock_type::duration>(std::chrono::nanoseconds(record.time_ns)) };
+
+        _row.str(std::string());
+        server_lib::render_cli_row(_row, _msg, time, record.details_filter, _options.time_format, application_name);
+        output() << _row.str();
+    }
+
+private:
+    const options _options;
+    std::ofstream _file;
+    logger::log_message _msg;
+    std::ostringstream _row;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        collector(opts).run();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "ll-collector: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,438 @@
+// Prints records of file destination in time range filtered by level or thread
+//
+// ll-query [--from TIME] [--to TIME] [--level LEVEL] [--thread ID] [--time-format FMT] FILE...
+//
+// TIME is local time in the format of rows (logger::default_time_format).
+// ID is thread id or pid:tid (file_options::shared rows).
+// Blocks are found by side index (file_options::write_index) if it exists,
+// otherwise raw file is binary searched by row time (rows are expected sorted).
+
+#include <logger/logger.h>
+#include <logger/time_helper.h>
+
+#include "line_scanner.h"
+#include "log_index.h"
+#include "lz_block.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+using server_lib::logger;
+
+const int64_t us_in_second = 1000000;
+const int64_t no_time = std::numeric_limits<int64_t>::min();
+
+struct options
+{
+    std::string time_format = logger::default_time_format;
+    int64_t from_us = std::numeric_limits<int64_t>::min();
+    int64_t to_us = std::numeric_limits<int64_t>::max();
+    // Index of the least severe level to print (fatal is 0). All if negative
+    int max_level = -1;
+    std::string thread;
+    std::vector<std::string> files;
+};
+
+// In order of logger::level_index
+const char* const level_tags[] = { "[fatal!!!]", "[error!]", "[warning]", "[info]", "[debug]", "[trace]" };
+const char* const level_names[] = { "fatal", "error", "warning", "info", "debug", "trace" };
+const int levels_count = 6;
+
+class mapped_file
+{
+public:
+    explicit mapped_file(const std::string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                _data = static_cast<const char*>(p);
+                _size = static_cast<size_t>(st.st_size);
+                madvise(p, _size, MADV_RANDOM);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~mapped_file()
+    {
+        if (_data)
+            munmap(const_cast<char*>(_data), _size);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    const char* data() const
+    {
+        return _data;
+    }
+    size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    const char* _data = nullptr;
+    size_t _size = 0;
+};
+
+class query
+{
+public:
+    explicit query(const options& opts)
+        : _options(opts)
+    {
+    }
+
+    void run(const std::string& path)
+    {
+        mapped_file file(path);
+        if (!file.data())
+        {
+            std::cerr << "ll-query: can't read " << path << std::endl;
+            return;
+        }
+
+        _last_time_us = no_time;
+        _last_time_text.clear();
+        // Rows before the first header can't be filtered
+        _last_match = _options.max_level < 0 && _options.thread.empty();
+
+        const bool compressed = file.size() >= 4 && memcmp(file.data(), "LLZB", 4) == 0;
+
+        std::vector<server_lib::log_index_entry> entries;
+        server_lib::log_index_bounds bounds;
+        if (read_index(path, file.size(), entries, bounds))
+        {
+            auto range = server_lib::find_log_blocks(bounds, _options.from_us, _options.to_us);
+            for (size_t ci = range.first; ci < range.second; ++ci)
+            {
+                const auto& entry = entries[ci];
+                process_block(file.data() + entry.offset, static_cast<size_t>(entry.size), compressed);
+            }
+        }
+        else if (compressed)
+        {
+            process_block(file.data(), file.size(), true);
+        }
+        else
+        {
+            const size_t start = lower_bound_row(file.data(), file.size());
+            process(file.data() + start, file.size() - start, true);
+        }
+        fflush(stdout);
+    }
+
+private:
+    bool read_index(const std::string& path, size_t file_size, std::vector<server_lib::log_index_entry>& entries, server_lib::log_index_bounds& bounds)
+    {
+        mapped_file index(server_lib::log_index_path(path));
+        if (!index.data() || !server_lib::read_log_index(index.data(), index.size(), entries))
+            return false;
+
+        // Index could be ahead of truncated file
+        auto it = std::find_if(entries.begin(), entries.end(), [file_size](const server_lib::log_index_entry& entry) {
+            return entry.offset + entry.size > file_size;
+        });
+        entries.erase(it, entries.end());
+        server_lib::make_log_index_bounds(entries, bounds);
+        return true;
+    }
+
+    void process_block(const char* data, size_t size, bool compressed)
+    {
+        if (!compressed)
+        {
+            process(data, size, false);
+            return;
+        }
+        _decoded.clear();
+        server_lib::decode_lz_frames(data, size, _decoded);
+        process(_decoded.data(), _decoded.size(), false);
+    }
+
+    // Rows are sorted if there is no index
+    void process(const char* data, size_t size, bool stop_after_range)
+    {
+        const char* end = data + size;
+        while (data < end)
+        {
+            const char* line_end = server_lib::find_new_line(data, end);
+            const size_t line_size = static_cast<size_t>(line_end - data);
+
+            const char* rest = nullptr;
+            bool header = false;
+            const int64_t time_us = row_time(data, line_size, rest, header);
+            if (time_us > _options.to_us && stop_after_range)
+                break;
+            // Continuation rows (multiline messages, hex dumps) follow their header
+            if (header)
+                _last_match = match(rest, line_end);
+            if (time_us >= _options.from_us && time_us <= _options.to_us && _last_match)
+            {
+                fwrite(data, 1, line_size, stdout);
+                fputc('\n', stdout);
+            }
+            data = line_end + 1;
+        }
+    }
+
+    // Header fields after time: [.micro ][level tag][thread info]message.
+    // Level tag is right aligned by spaces to 11 chars. Thread info is
+    // [tid], [tid-name] or shared mode [pid], [pid:tid], [pid:tid-name]
+    // (no one for main thread of not shared mode). Rows without level
+    // detail pass level filter
+    bool match(const char* p, const char* line_end) const
+    {
+        if (p < line_end && *p == '.')
+        {
+            ++p;
+            while (p < line_end && *p >= '0' && *p <= '9')
+                ++p;
+        }
+
+        const char* tag = p;
+        while (tag < line_end && *tag == ' ')
+            ++tag;
+        for (int ci = 0; ci < levels_count; ++ci)
+        {
+            const size_t tag_size = strlen(level_tags[ci]);
+            if (static_cast<size_t>(line_end - tag) > tag_size && !memcmp(tag, level_tags[ci], tag_size) && tag[tag_size] == ' ')
+            {
+                if (_options.max_level >= 0 && ci > _options.max_level)
+                    return false;
+                p = tag + tag_size + 1;
+                break;
+            }
+        }
+
+        if (_options.thread.empty())
+            return true;
+
+        std::string pid, tid;
+        if (!parse_thread_info(p, line_end, pid, tid) || tid.empty())
+            return false;
+        // Thread id or pid:tid
+        return _options.thread == tid || _options.thread == pid + ':' + tid;
+    }
+
+    static bool parse_thread_info(const char* p, const char* line_end, std::string& pid, std::string& tid)
+    {
+        if (p >= line_end || *p != '[')
+            return false;
+        ++p;
+
+        auto parse_number = [line_end](const char*& p, std::string& number) {
+            const char* start = p;
+            while (p < line_end && *p >= '0' && *p <= '9')
+                ++p;
+            number.assign(start, p);
+            return p != start;
+        };
+
+        std::string first;
+        if (!parse_number(p, first))
+            return false;
+        if (p < line_end && *p == ':')
+        {
+            ++p;
+            pid = first;
+            if (!parse_number(p, tid))
+                return false;
+        }
+        else
+        {
+            // [pid] of main thread in shared mode looks the same
+            tid = first;
+        }
+
+        if (p < line_end && *p == '-')
+            p = std::find(p, line_end, ']');
+        return p < line_end && *p == ']';
+    }
+
+    // Row: [app: ]time[.micro] [level] [thread]message.
+    // Row without time (continuation of multiline message) gets previous time
+    // and isn't header
+    int64_t row_time(const char* line, size_t size, const char*& rest, bool& header)
+    {
+        header = false;
+        const char* end = line + size;
+        const char* p = line;
+        if (p < end && (*p < '0' || *p > '9'))
+        {
+            const char* limit = line + std::min<size_t>(size, 64);
+            const char* colon = std::search(p, limit, ": ", ": " + 2);
+            if (colon == limit)
+            {
+                rest = line;
+                return _last_time_us;
+            }
+            p = colon + 2;
+        }
+
+        const char* time_end = p;
+        while (time_end < end && *time_end != '.' && *time_end != ' ' && *time_end != '[')
+            ++time_end;
+
+        rest = time_end;
+        if (time_end == p)
+            return _last_time_us;
+
+        // Rows of the same second share parsed time
+        if (_last_time_text.size() != static_cast<size_t>(time_end - p) || _last_time_text.compare(0, std::string::npos, p, static_cast<size_t>(time_end - p)))
+        {
+            _last_time_text.assign(p, time_end);
+            time_t seconds = 0;
+            if (server_lib::parse_iso_time(p, static_cast<size_t>(time_end - p), _options.time_format.c_str(), seconds, false))
+                _last_second_us = no_time;
+            else
+                _last_second_us = static_cast<int64_t>(seconds) * us_in_second;
+        }
+        if (_last_second_us == no_time)
+            return _last_time_us;
+
+        header = true;
+        _last_time_us = _last_second_us;
+        return _last_time_us;
+    }
+
+    size_t lower_bound_row(const char* data, size_t size)
+    {
+        if (_options.from_us == std::numeric_limits<int64_t>::min())
+            return 0;
+
+        size_t lo = 0;
+        size_t hi = size;
+        while (lo < hi)
+        {
+            const size_t mid = lo + (hi - lo) / 2;
+            const char* row = (mid == 0) ? data : server_lib::find_new_line(data + mid - 1, data + size) + 1;
+            if (row >= data + size)
+            {
+                hi = mid;
+                continue;
+            }
+            const char* row_end = server_lib::find_new_line(row, data + size);
+
+            _last_time_us = no_time;
+            const char* rest = nullptr;
+            bool header = false;
+            const int64_t time_us = row_time(row, static_cast<size_t>(row_end - row), rest, header);
+            if (time_us != no_time && time_us < _options.from_us)
+                lo = static_cast<size_t>(row_end - data) + 1;
+            else
+                hi = mid;
+        }
+        _last_time_us = no_time;
+        // Start from the row beginning
+        while (lo > 0 && lo < size && data[lo - 1] != '\n')
+            --lo;
+        return std::min(lo, size);
+    }
+
+private:
+    const options& _options;
+    std::string _decoded;
+    // Filter result of the last header row
+    bool _last_match = true;
+
+    int64_t _last_time_us = no_time;
+    int64_t _last_second_us = no_time;
+    std::string _last_time_text;
+};
+
+void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program
+              << " [--from TIME] [--to TIME] [--level LEVEL] [--thread ID] [--time-format FMT] FILE...\n";
+}
+
+bool parse_time(const options& opts, const std::string& text, int64_t& time_us)
+{
+    time_t seconds = 0;
+    if (server_lib::parse_iso_time(text.data(), text.size(), opts.time_format.c_str(), seconds, false))
+        return false;
+    time_us = static_cast<int64_t>(seconds) * us_in_second;
+    return true;
+}
+
+bool parse_options(int argc, char* argv[], options& result)
+{
+    std::string from, to;
+    for (int ci = 1; ci < argc; ++ci)
+    {
+        const std::string arg = argv[ci];
+        const bool has_value = ci + 1 < argc;
+        if (arg == "--from" && has_value)
+            from = argv[++ci];
+        else if (arg == "--to" && has_value)
+            to = argv[++ci];
+        else if (arg == "--thread" && has_value)
+            result.thread = argv[++ci];
+        else if (arg == "--time-format" && has_value)
+            result.time_format = argv[++ci];
+        else if (arg == "--level" && has_value)
+        {
+            const std::string name = argv[++ci];
+            for (int cj = 0; cj < levels_count; ++cj)
+            {
+                if (name == level_names[cj])
+                    result.max_level = cj;
+            }
+            if (result.max_level < 0)
+                return false;
+        }
+        else if (!arg.empty() && arg[0] == '-')
+            return false;
+        else
+            result.files.push_back(arg);
+    }
+
+    if (!from.empty() && !parse_time(result, from, result.from_us))
+        return false;
+    if (!to.empty())
+    {
+        if (!parse_time(result, to, result.to_us))
+            return false;
+        // The whole last second
+        result.to_us += us_in_second - 1;
+    }
+    return !result.files.empty();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    query q(opts);
+    for (const auto& path : opts.files)
+        q.run(path);
+    return 0;
+}
@@ -0,0 +1,41 @@
+// Decodes compressed log file (file_options::compress) to standard output.
+// Damaged frames are skipped
+//
+// ll-unpack FILE...
+
+#include "lz_block.h"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " FILE...\n";
+        return 1;
+    }
+
+    int result = 0;
+    std::string out;
+    for (int ci = 1; ci < argc; ++ci)
+    {
+        std::ifstream input(argv[ci], std::ios::binary);
+        if (!input)
+        {
+            std::cerr << "ll-unpack: can't open " << argv[ci] << std::endl;
+            result = 1;
+            continue;
+        }
+        const std::string data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+        out.clear();
+        const auto skipped = server_lib::decode_lz_frames(data.data(), data.size(), out);
+        std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (skipped)
+            std::cerr << "ll-unpack: " << argv[ci] << ": " << skipped << " damaged bytes skipped" << std::endl;
+    }
+    return result;
+}